@@ -21,7 +21,7 @@ public class FirstPersonCpp : ModuleRules
 			"Slate"
 		});
 
-		PrivateDependencyModuleNames.AddRange(new string[] { });
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json", "JsonUtilities" });
 
 		PublicIncludePaths.AddRange(new string[] {
 			"FirstPersonCpp",
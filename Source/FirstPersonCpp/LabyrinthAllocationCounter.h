@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Counts how often scratch arrays are (re)allocated.
+ * Every call that can grow a scratch array goes through here and compares the array's capacity before and after,
+ * so a buffer that grows is counted however it was grown.
+ */
+class FLabyrinthAllocationCounter
+{
+public:
+	template<typename ArrayType, typename ElementType>
+	void Add(ArrayType& array, ElementType&& element)
+	{
+		Track(array, [&] { array.Add(Forward<ElementType>(element)); });
+	}
+
+	template<typename ArrayType, typename OtherArrayType>
+	void Append(ArrayType& array, const OtherArrayType& other)
+	{
+		Track(array, [&] { array.Append(other); });
+	}
+
+	template<typename ArrayType, typename ElementType>
+	void Init(ArrayType& array, const ElementType& element, int32 number)
+	{
+		Track(array, [&] { array.Init(element, number); });
+	}
+
+	template<typename ArrayType>
+	void SetNum(ArrayType& array, int32 number)
+	{
+		Track(array, [&] { array.SetNum(number, EAllowShrinking::No); });
+	}
+
+	template<typename ArrayType>
+	void SetNumUninitialized(ArrayType& array, int32 number)
+	{
+		Track(array, [&] { array.SetNumUninitialized(number, EAllowShrinking::No); });
+	}
+
+	template<typename ArrayType>
+	void Reserve(ArrayType& array, int32 number)
+	{
+		Track(array, [&] { array.Reserve(number); });
+	}
+
+	int32 Num() const { return NumAllocations; }
+	void Reset() { NumAllocations = 0; }
+
+private:
+	template<typename ArrayType, typename OperationType>
+	void Track(ArrayType& array, OperationType&& operation)
+	{
+		const auto previousMax{ array.Max() };
+		const auto* previousData{ array.GetData() };
+
+		operation();
+
+		if (array.Max() != previousMax || array.GetData() != previousData)
+		{
+			NumAllocations++;
+		}
+	}
+
+	int32 NumAllocations = 0;
+};
@@ -0,0 +1,397 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthBenchmarkCommandlet.h"
+
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "LabyrinthCommandletParams.h"
+#include "LabyrinthLayoutGenerator.h"
+#include "LabyrinthRingBuffer.h"
+#include "LabyrinthScratchArena.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLabyrinthBenchmark, Log, All);
+
+namespace
+{
+    // Parse a comma separated list of positive integers such as "40,128,512".
+    bool ParseIntList(const FString& text, TArray<int32>& outValues)
+    {
+        TArray<FString> entries;
+        text.ParseIntoArray(entries, TEXT(","));
+
+        outValues.Reset();
+        for (const FString& entry : entries)
+        {
+            if (!entry.IsNumeric() || FCString::Atoi(*entry) < 1)
+            {
+                return false;
+            }
+            outValues.Add(FCString::Atoi(*entry));
+        }
+
+        return !outValues.IsEmpty();
+    }
+
+    // Parse per size budgets such as "512:50,4096:2000" into milliseconds keyed by labyrinth size.
+    bool ParseBudgetList(const FString& text, TMap<int32, double>& outBudgets)
+    {
+        TArray<FString> entries;
+        text.ParseIntoArray(entries, TEXT(","));
+
+        outBudgets.Reset();
+        for (const FString& entry : entries)
+        {
+            FString sizeText;
+            FString budgetText;
+            if (!entry.Split(TEXT(":"), &sizeText, &budgetText) || !sizeText.IsNumeric() || !budgetText.IsNumeric() ||
+                FCString::Atoi(*sizeText) < 1 || FCString::Atod(*budgetText) <= 0.0)
+            {
+                return false;
+            }
+            outBudgets.Add(FCString::Atoi(*sizeText), FCString::Atod(*budgetText));
+        }
+
+        return !outBudgets.IsEmpty();
+    }
+
+    double ToMs(double seconds)
+    {
+        return seconds * 1000.0;
+    }
+
+    // The distance field as it was stored before TLabyrinthGrid: one array per row, indexed [y][x], with rooms, halls
+    // and unreached cells encoded in the distance itself.
+    constexpr int32 NestedRoom{ MAX_int32 };
+    constexpr int32 NestedUnreached{ MAX_int32 - 1 };
+    constexpr int32 NestedHall{ MIN_int32 };
+
+    void InitNestedDistances(const FLabyrinthDistanceField& field, TArray<TArray<int32>>& outDistances)
+    {
+        const FIntVector2 dimensions{ field.GetDimensions() };
+        outDistances.SetNum(dimensions.Y);
+
+        for (int32 y = 0; y < dimensions.Y; y++)
+        {
+            outDistances[y].SetNumUninitialized(dimensions.X);
+            for (int32 x = 0; x < dimensions.X; x++)
+            {
+                const FIntVector2 cell{ x, y };
+                outDistances[y][x] =
+                    field.IsRoom(cell) ? NestedRoom :
+                    field.IsHall(cell) ? NestedHall :
+                    field.IsPotentialDoor(cell) ? 0 :
+                    NestedUnreached;
+            }
+        }
+    }
+
+    void CopyNestedDistances(const TArray<TArray<int32>>& source, TArray<TArray<int32>>& destination)
+    {
+        for (int32 y = 0; y < source.Num(); y++)
+        {
+            FMemory::Memcpy(destination[y].GetData(), source[y].GetData(), source[y].Num() * sizeof(int32));
+        }
+    }
+
+    // The old RecalculateDistanceField over nested arrays. It uses the same ring buffer of cell indices as the grid
+    // flood, so only the storage differs between the two.
+    int32 FloodNestedArrays(TArray<TArray<int32>>& distances, TConstArrayView<FIntVector2> seeds, TLabyrinthRingBuffer<int32>& frontier)
+    {
+        const int32 height{ distances.Num() };
+        const int32 width{ height > 0 ? distances[0].Num() : 0 };
+
+        frontier.Reset();
+        for (FIntVector2 seed : seeds)
+        {
+            frontier.Push((seed.Y * width) + seed.X);
+        }
+
+        int32 numVisited{ 0 };
+        int32 currentIndex{};
+        while (frontier.Pop(currentIndex))
+        {
+            numVisited++;
+
+            const int32 x{ currentIndex % width };
+            const int32 y{ currentIndex / width };
+
+            // max(distance, 0) to handle the hall sentinel
+            const int32 nextDistance{ FMath::Max(distances[y][x], 0) + 1 };
+
+            const FIntVector2 neighbors[]{ { x - 1, y }, { x + 1, y }, { x, y - 1 }, { x, y + 1 } };
+            for (FIntVector2 neighbor : neighbors)
+            {
+                if (neighbor.X < 0 || neighbor.Y < 0 || neighbor.X >= width || neighbor.Y >= height)
+                {
+                    continue;
+                }
+
+                int32& distance = distances[neighbor.Y][neighbor.X];
+                if (distance != NestedRoom && distance > nextDistance)
+                {
+                    distance = nextDistance;
+                    frontier.Push((neighbor.Y * width) + neighbor.X);
+                }
+            }
+        }
+
+        return numVisited;
+    }
+
+    bool NestedDistancesMatch(const TArray<TArray<int32>>& nested, const FLabyrinthDistanceField& field)
+    {
+        const FIntVector2 dimensions{ field.GetDimensions() };
+        for (int32 y = 0; y < dimensions.Y; y++)
+        {
+            for (int32 x = 0; x < dimensions.X; x++)
+            {
+                const int32 distance{ nested[y][x] };
+                if (distance == NestedRoom)
+                {
+                    continue;
+                }
+
+                const uint32 expected{ distance == NestedUnreached ? FLabyrinthDistanceField::Unreached : static_cast<uint32>(FMath::Max(distance, 0)) };
+                if (field.GetDistance(FIntVector2{ x, y }) != expected)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // The kernel RecalculateDistanceField picks for these parameters.
+    int32 FloodLikeGenerator(FLabyrinthDistanceField& field, TConstArrayView<FIntVector2> seeds, const FLabyrinthLayoutParams& params, FLabyrinthScratchArena& scratchArena)
+    {
+        if (params.ParallelDistanceFieldMinCells > 0 && field.Num() >= params.ParallelDistanceFieldMinCells)
+        {
+            return field.Flood(seeds, scratchArena.GetParallelFlood());
+        }
+
+        if (params.bWavefrontDistanceField)
+        {
+            return field.Flood(seeds, scratchArena.GetWavefront());
+        }
+
+        return field.Flood(seeds, scratchArena.GetFrontier());
+    }
+}
+
+ULabyrinthBenchmarkCommandlet::ULabyrinthBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 ULabyrinthBenchmarkCommandlet::Main(const FString& Params)
+{
+    TArray<int32> dimensions{ 40, 64, 128, 512, 1024, 4096 };
+    TArray<int32> roomCounts{ 8, 50, 200, 2000 };
+    int32 repeats{ 3 };
+    int32 seed{ 1 };
+    TMap<int32, double> budgetsMs;
+    FLabyrinthLayoutParams baseParams{};
+    FString outputPath{ FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"), TEXT("LabyrinthBenchmark.csv")) };
+
+    FString listText;
+    if (FParse::Value(*Params, TEXT("Dimensions="), listText, false) && !ParseIntList(listText, dimensions))
+    {
+        UE_LOG(LogLabyrinthBenchmark, Error, TEXT("Could not read -Dimensions=%s"), *listText);
+        return 1;
+    }
+
+    if (FParse::Value(*Params, TEXT("Rooms="), listText, false) && !ParseIntList(listText, roomCounts))
+    {
+        UE_LOG(LogLabyrinthBenchmark, Error, TEXT("Could not read -Rooms=%s"), *listText);
+        return 1;
+    }
+
+    if (FParse::Value(*Params, TEXT("BudgetMs="), listText, false) && !ParseBudgetList(listText, budgetsMs))
+    {
+        UE_LOG(LogLabyrinthBenchmark, Error, TEXT("Could not read -BudgetMs=%s, expected size:ms pairs such as 512:50,4096:2000"), *listText);
+        return 1;
+    }
+
+    FParse::Value(*Params, TEXT("Repeats="), repeats);
+    FParse::Value(*Params, TEXT("Seed="), seed);
+    FParse::Value(*Params, TEXT("Output="), outputPath);
+    repeats = FMath::Max(repeats, 1);
+
+    FString paramsError;
+    if (!LabyrinthCommandletParams::ParseGeneratorParams(Params, baseParams, paramsError))
+    {
+        UE_LOG(LogLabyrinthBenchmark, Error, TEXT("%s"), *paramsError);
+        return 1;
+    }
+
+    const bool bGridCompare{ FParse::Param(*Params, TEXT("GridCompare")) };
+
+    FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*FPaths::GetPath(outputPath));
+
+    TArray<FString> csvLines;
+    csvLines.Add(TEXT("width,height,rooms,seed,repeat,placed_rooms,hall_cells,total_ms,rooms_ms,distance_field_ms,corridors_ms,doors_ms,walls_ms,failed_search_paths,scratch_allocations,generator_bytes,process_peak_bytes"));
+
+    TArray<FString> gridCsvLines;
+    gridCsvLines.Add(TEXT("width,height,rooms,seed,cells_visited,nested_ms,grid_ms,generator_distance_field_ms"));
+
+    FLabyrinthLayoutGenerator generator;
+    FLabyrinthLayout layout;
+    int32 numOverBudget{ 0 };
+    int32 numGridMismatches{ 0 };
+
+    for (int32 size : dimensions)
+    {
+        for (int32 numRooms : roomCounts)
+        {
+            // Room placement keeps searching until every room is placed, so leave plenty of room to spare.
+            int64 roomArea{ static_cast<int64>(baseParams.RoomCellSize.X) * baseParams.RoomCellSize.Y };
+            if (static_cast<int64>(numRooms) * roomArea * 4 > static_cast<int64>(size) * size)
+            {
+                UE_LOG(LogLabyrinthBenchmark, Display, TEXT("Skipping %i rooms in %i x %i, they would not fit"), numRooms, size, size);
+                continue;
+            }
+
+            FLabyrinthLayoutParams params{ baseParams };
+            params.Seed = seed;
+            params.Dimensions = FIntVector2{ size, size };
+            params.NumberOfRooms = numRooms;
+
+            double fastestMs{ TNumericLimits<double>::Max() };
+
+            for (int32 repeat = 0; repeat < repeats; repeat++)
+            {
+                // A fresh generator for the first repeat so its allocation counts include warming the scratch buffers.
+                if (repeat == 0)
+                {
+                    generator = FLabyrinthLayoutGenerator{};
+                }
+
+                if (!generator.Generate(params, layout))
+                {
+                    UE_LOG(LogLabyrinthBenchmark, Error, TEXT("Generation failed for %i rooms in %i x %i"), numRooms, size, size);
+                    return 1;
+                }
+
+                const FLabyrinthGenerationStats& stats = generator.GetStats();
+                fastestMs = FMath::Min(fastestMs, ToMs(stats.TotalSeconds));
+
+                csvLines.Add(FString::Printf(TEXT("%i,%i,%i,%i,%i,%i,%i,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%i,%i,%llu,%llu"),
+                    size, size, numRooms, seed, repeat, layout.Rooms.Num(), layout.HallCells.Num(),
+                    ToMs(stats.TotalSeconds), ToMs(stats.RoomPlacementSeconds), ToMs(stats.DistanceFieldSeconds),
+                    ToMs(stats.CorridorSeconds), ToMs(stats.DoorSeconds), ToMs(stats.WallSeconds),
+                    stats.NumFailedSearchPaths, stats.NumScratchAllocations,
+                    static_cast<uint64>(stats.AllocatedBytes), static_cast<uint64>(FPlatformMemory::GetStats().PeakUsedPhysical)));
+            }
+
+            UE_LOG(LogLabyrinthBenchmark, Display, TEXT("%i x %i, %i rooms: fastest %.3f ms"), size, size, numRooms, fastestMs);
+
+            const double* budgetMs{ budgetsMs.Find(size) };
+            if (budgetMs && fastestMs > *budgetMs)
+            {
+                UE_LOG(LogLabyrinthBenchmark, Error, TEXT("%i x %i, %i rooms took %.3f ms, over the %.3f ms budget"), size, size, numRooms, fastestMs, *budgetMs);
+                numOverBudget++;
+            }
+
+            if (bGridCompare && !CompareGridFlood(generator, params, repeats, gridCsvLines))
+            {
+                numGridMismatches++;
+            }
+        }
+    }
+
+    if (!FFileHelper::SaveStringArrayToFile(csvLines, *outputPath))
+    {
+        UE_LOG(LogLabyrinthBenchmark, Error, TEXT("Could not write %s"), *outputPath);
+        return 1;
+    }
+
+    UE_LOG(LogLabyrinthBenchmark, Display, TEXT("Wrote %s"), *outputPath);
+
+    if (bGridCompare)
+    {
+        FString gridOutputPath{ FPaths::Combine(FPaths::GetPath(outputPath), TEXT("LabyrinthGridComparison.csv")) };
+        if (!FFileHelper::SaveStringArrayToFile(gridCsvLines, *gridOutputPath))
+        {
+            UE_LOG(LogLabyrinthBenchmark, Error, TEXT("Could not write %s"), *gridOutputPath);
+            return 1;
+        }
+
+        UE_LOG(LogLabyrinthBenchmark, Display, TEXT("Wrote %s"), *gridOutputPath);
+    }
+
+    return numOverBudget == 0 && numGridMismatches == 0 ? 0 : 1;
+}
+
+bool ULabyrinthBenchmarkCommandlet::CompareGridFlood(const FLabyrinthLayoutGenerator& generator, const FLabyrinthLayoutParams& params, int32 repeats, TArray<FString>& csvLines) const
+{
+    // Both floods start from the cells and zero distance cells of the layout just generated.
+    FLabyrinthDistanceField field{ generator.GetDistanceField() };
+    const FIntVector2 dimensions{ field.GetDimensions() };
+
+    TArray<FIntVector2> seeds;
+    for (int32 y = 0; y < dimensions.Y; y++)
+    {
+        for (int32 x = 0; x < dimensions.X; x++)
+        {
+            if (field.IsHall(FIntVector2{ x, y }) || field.IsPotentialDoor(FIntVector2{ x, y }))
+            {
+                seeds.Add(FIntVector2{ x, y });
+            }
+        }
+    }
+
+    TArray<TArray<int32>> initialNested;
+    InitNestedDistances(field, initialNested);
+    TArray<TArray<int32>> nested{ initialNested };
+
+    TLabyrinthRingBuffer<int32> nestedFrontier;
+    FLabyrinthScratchArena scratchArena;
+    scratchArena.Prepare(dimensions);
+
+    double nestedMs{ TNumericLimits<double>::Max() };
+    double gridMs{ TNumericLimits<double>::Max() };
+    int32 nestedVisited{ 0 };
+    int32 gridVisited{ 0 };
+
+    // The first run of each only warms the caches and grows the frontiers. Resetting happens outside the timers.
+    for (int32 run = 0; run <= repeats; run++)
+    {
+        CopyNestedDistances(initialNested, nested);
+        double nestedStart{ FPlatformTime::Seconds() };
+        nestedVisited = FloodNestedArrays(nested, seeds, nestedFrontier);
+        double nestedRunMs{ ToMs(FPlatformTime::Seconds() - nestedStart) };
+
+        field.ResetDistances();
+        double gridStart{ FPlatformTime::Seconds() };
+        gridVisited = FloodLikeGenerator(field, seeds, params, scratchArena);
+        double gridRunMs{ ToMs(FPlatformTime::Seconds() - gridStart) };
+
+        if (run > 0)
+        {
+            nestedMs = FMath::Min(nestedMs, nestedRunMs);
+            gridMs = FMath::Min(gridMs, gridRunMs);
+        }
+    }
+
+    const bool bMatches{ nestedVisited == gridVisited && NestedDistancesMatch(nested, field) };
+    if (!bMatches)
+    {
+        UE_LOG(LogLabyrinthBenchmark, Error, TEXT("Grid comparison at %i x %i disagrees: %i cells visited nested, %i on the grid"),
+            dimensions.X, dimensions.Y, nestedVisited, gridVisited);
+    }
+
+    const double generatorMs{ ToMs(generator.GetStats().DistanceFieldSeconds) };
+
+    UE_LOG(LogLabyrinthBenchmark, Display, TEXT("Flood %i x %i, %i rooms: nested arrays %.3f ms, grid %.3f ms, generator distance field %.3f ms"),
+        dimensions.X, dimensions.Y, params.NumberOfRooms, nestedMs, gridMs, generatorMs);
+    csvLines.Add(FString::Printf(TEXT("%i,%i,%i,%i,%i,%.3f,%.3f,%.3f"),
+        dimensions.X, dimensions.Y, params.NumberOfRooms, params.Seed, gridVisited, nestedMs, gridMs, generatorMs));
+
+    return bMatches;
+}
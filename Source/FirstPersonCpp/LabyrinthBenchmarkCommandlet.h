@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "LabyrinthBenchmarkCommandlet.generated.h"
+
+class FLabyrinthLayoutGenerator;
+struct FLabyrinthLayoutParams;
+
+/**
+ * Times layout generation over a matrix of labyrinth sizes and room counts, headless, and writes the results as CSV.
+ * Returns non zero when the fastest repeat of any configuration exceeds the -BudgetMs budget for its size, or when the
+ * -GridCompare floods disagree, so it can gate a build.
+ *
+ * UnrealEditor-Cmd.exe FirstPersonCpp.uproject -run=LabyrinthBenchmark
+ *     -Dimensions=40,64,128,512,1024,4096 -Rooms=8,50,200,2000 -Repeats=3 -Seed=1 -BudgetMs=40:5,512:50,4096:2000
+ *     -Room=/Game/Labyrinth/Blueprints/Room.Room_C -Strategy=SearchRays -CandidateRays=1 -RoomBatch=1 -Output=<csv file> [-Wavefront] [-ParallelMinCells=<cells>] [-GridCompare]
+ *
+ * Configurations with more rooms than could fit are skipped. Sizes without a budget are not gated.
+ * -Room defaults to the project's room blueprint, and the room class must have doors.
+ * -GridCompare also floods each generated layout from scratch with the old nested array distance field and with the
+ * kernel the generator uses, over warmed repeats, and writes the fastest of each next to the CSV. The default sizes
+ * include 64, 512 and 4096, so -GridCompare alone reproduces the flat grid comparison at those sizes.
+ */
+UCLASS()
+class ULabyrinthBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	ULabyrinthBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	// Returns false if the two floods left different distances.
+	bool CompareGridFlood(const FLabyrinthLayoutGenerator& generator, const FLabyrinthLayoutParams& params, int32 repeats, TArray<FString>& csvLines) const;
+};
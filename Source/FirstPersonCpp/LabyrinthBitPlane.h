@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * One bit per grid cell, packed into 64-bit words.
+ * Every row starts on a fresh word so whole rows can be processed a word at a time.
+ */
+class FLabyrinthBitPlane
+{
+public:
+	static constexpr int32 BitsPerWord = 64;
+
+	FLabyrinthBitPlane() = default;
+
+	// Resize to the given dimensions and clear every bit.
+	// The existing allocation is reused when the word count does not change.
+	void Init(FIntVector2 dimensions)
+	{
+		Width = FMath::Max(dimensions.X, 0);
+		Height = FMath::Max(dimensions.Y, 0);
+		WordsPerRow = (Width + BitsPerWord - 1) / BitsPerWord;
+		Words.Init(0, WordsPerRow * Height);
+	}
+
+	void ClearAll()
+	{
+		FMemory::Memzero(Words.GetData(), Words.Num() * sizeof(uint64));
+	}
+
+	bool Get(FIntVector2 cell) const
+	{
+		checkSlow(IsInBounds(cell));
+		return (Words[WordIndex(cell)] & BitMask(cell.X)) != 0;
+	}
+
+	void Set(FIntVector2 cell)
+	{
+		checkSlow(IsInBounds(cell));
+		Words[WordIndex(cell)] |= BitMask(cell.X);
+	}
+
+	void Clear(FIntVector2 cell)
+	{
+		checkSlow(IsInBounds(cell));
+		Words[WordIndex(cell)] &= ~BitMask(cell.X);
+	}
+
+	// Set the bit and report whether it was already set.
+	bool TestAndSet(FIntVector2 cell)
+	{
+		checkSlow(IsInBounds(cell));
+		uint64& word = Words[WordIndex(cell)];
+		const uint64 mask = BitMask(cell.X);
+		const bool wasSet = (word & mask) != 0;
+		word |= mask;
+		return wasSet;
+	}
+
+	bool IsInBounds(FIntVector2 cell) const
+	{
+		return
+			(cell.X >= 0) &&
+			(cell.Y >= 0) &&
+			(cell.X < Width) &&
+			(cell.Y < Height);
+	}
+
+	int32 GetWidth() const { return Width; }
+	int32 GetHeight() const { return Height; }
+	int32 GetWordsPerRow() const { return WordsPerRow; }
+
+	TArrayView<uint64> GetRowWords(int32 y)
+	{
+		checkSlow(y >= 0 && y < Height);
+		return TArrayView<uint64>(Words.GetData() + (y * WordsPerRow), WordsPerRow);
+	}
+
+	TConstArrayView<uint64> GetRowWords(int32 y) const
+	{
+		checkSlow(y >= 0 && y < Height);
+		return TConstArrayView<uint64>(Words.GetData() + (y * WordsPerRow), WordsPerRow);
+	}
+
+	SIZE_T GetAllocatedSize() const { return Words.GetAllocatedSize(); }
+
+private:
+	int32 WordIndex(FIntVector2 cell) const { return (cell.Y * WordsPerRow) + (cell.X / BitsPerWord); }
+	static uint64 BitMask(int32 x) { return uint64(1) << (x % BitsPerWord); }
+
+	TArray<uint64> Words;
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 WordsPerRow = 0;
+};
@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthBitboardPlacer.h"
+
+bool FLabyrinthBitboardPlacer::FindNearestFit(const FLabyrinthBitPlane& blocked, FIntVector2 roomSize, FIntVector2 target, FIntVector2& outCell, int32 edgeMargin)
+{
+    const int32 usableWidth{ blocked.GetWidth() - edgeMargin };
+    const int32 lastY{ blocked.GetHeight() - edgeMargin - roomSize.Y };
+    if (roomSize.X < 1 || roomSize.Y < 1 || roomSize.X > usableWidth || lastY < 0)
+    {
+        return false;
+    }
+
+    target.X = FMath::Clamp(target.X, 0, usableWidth - roomSize.X);
+    target.Y = FMath::Clamp(target.Y, 0, lastY);
+
+    int64 bestDistance{ MAX_int64 };
+
+    // Visit rows outwards from the target, alternating sides, until no row left can beat the best fit.
+    for (int32 rowOffset = 0; rowOffset <= FMath::Max(target.Y, lastY - target.Y); rowOffset++)
+    {
+        int64 rowDistance{ static_cast<int64>(rowOffset) * rowOffset };
+        if (rowDistance >= bestDistance)
+        {
+            break;
+        }
+
+        const int32 rows[]{ target.Y - rowOffset, target.Y + rowOffset };
+        const int32 numRows{ rowOffset == 0 ? 1 : 2 };
+
+        for (int32 rowIndex = 0; rowIndex < numRows; rowIndex++)
+        {
+            const int32 y{ rows[rowIndex] };
+            if (y < 0 || y > lastY)
+            {
+                continue;
+            }
+
+            BuildFitMask(blocked, y, roomSize, usableWidth);
+
+            int32 x{ FindNearestBit(FitMask, target.X) };
+            if (x == INDEX_NONE)
+            {
+                continue;
+            }
+
+            int64 distance{ rowDistance + (static_cast<int64>(x - target.X) * (x - target.X)) };
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                outCell = FIntVector2{ x, y };
+            }
+        }
+    }
+
+    return bestDistance != MAX_int64;
+}
+
+void FLabyrinthBitboardPlacer::BuildFitMask(const FLabyrinthBitPlane& blocked, int32 y, FIntVector2 roomSize, int32 usableWidth)
+{
+    const int32 wordsPerRow{ blocked.GetWordsPerRow() };
+
+    FitMask.SetNumUninitialized(wordsPerRow, EAllowShrinking::No);
+    Shifted.SetNumUninitialized(wordsPerRow, EAllowShrinking::No);
+
+    // Blocked anywhere in the rows the room would cover
+    FMemory::Memzero(FitMask.GetData(), wordsPerRow * sizeof(uint64));
+    for (int32 row = y; row < y + roomSize.Y; row++)
+    {
+        TConstArrayView<uint64> rowWords{ blocked.GetRowWords(row) };
+        for (int32 word = 0; word < wordsPerRow; word++)
+        {
+            FitMask[word] |= rowWords[word];
+        }
+    }
+
+    // Free cells, with the margin and the padding past the row's end counted as blocked so rooms cannot hang off the edge.
+    for (uint64& word : FitMask)
+    {
+        word = ~word;
+    }
+
+    for (int32 word = usableWidth / FLabyrinthBitPlane::BitsPerWord; word < wordsPerRow; word++)
+    {
+        const int32 bitsInside{ FMath::Max(usableWidth - (word * FLabyrinthBitPlane::BitsPerWord), 0) };
+        FitMask[word] &= (uint64(1) << bitsInside) - 1;
+    }
+
+    // Keep bit x only while the next covered cells are free too, doubling the covered width each pass.
+    int32 coveredWidth{ 1 };
+    while (coveredWidth < roomSize.X)
+    {
+        int32 step{ FMath::Min(coveredWidth, roomSize.X - coveredWidth) };
+
+        ShiftRowDown(FitMask, step, Shifted);
+        for (int32 word = 0; word < wordsPerRow; word++)
+        {
+            FitMask[word] &= Shifted[word];
+        }
+
+        coveredWidth += step;
+    }
+}
+
+void FLabyrinthBitboardPlacer::ShiftRowDown(TConstArrayView<uint64> source, int32 shift, TArrayView<uint64> destination)
+{
+    const int32 numWords{ source.Num() };
+    const int32 wordShift{ shift / FLabyrinthBitPlane::BitsPerWord };
+    const int32 bitShift{ shift % FLabyrinthBitPlane::BitsPerWord };
+
+    for (int32 word = 0; word < numWords; word++)
+    {
+        int32 low{ word + wordShift };
+        int32 high{ low + 1 };
+
+        uint64 lowBits{ low < numWords ? source[low] : 0 };
+        uint64 highBits{ high < numWords ? source[high] : 0 };
+
+        destination[word] = bitShift == 0 ? lowBits : (lowBits >> bitShift) | (highBits << (FLabyrinthBitPlane::BitsPerWord - bitShift));
+    }
+}
+
+int32 FLabyrinthBitboardPlacer::FindNearestBit(TConstArrayView<uint64> mask, int32 targetX)
+{
+    const int32 targetWord{ targetX / FLabyrinthBitPlane::BitsPerWord };
+    const int32 targetBit{ targetX % FLabyrinthBitPlane::BitsPerWord };
+
+    // Highest set bit at or below the target
+    int32 below{ INDEX_NONE };
+    for (int32 word = targetWord; word >= 0; word--)
+    {
+        uint64 bits{ mask[word] };
+        if (word == targetWord && targetBit < FLabyrinthBitPlane::BitsPerWord - 1)
+        {
+            bits &= (uint64(2) << targetBit) - 1;
+        }
+
+        if (bits != 0)
+        {
+            below = (word * FLabyrinthBitPlane::BitsPerWord) + 63 - static_cast<int32>(FMath::CountLeadingZeros64(bits));
+            break;
+        }
+    }
+
+    // Lowest set bit at or above the target
+    int32 above{ INDEX_NONE };
+    for (int32 word = targetWord; word < mask.Num(); word++)
+    {
+        uint64 bits{ mask[word] };
+        if (word == targetWord)
+        {
+            bits &= ~((uint64(1) << targetBit) - 1);
+        }
+
+        if (bits != 0)
+        {
+            above = (word * FLabyrinthBitPlane::BitsPerWord) + static_cast<int32>(FMath::CountTrailingZeros64(bits));
+            break;
+        }
+    }
+
+    if (below == INDEX_NONE) { return above; }
+    if (above == INDEX_NONE) { return below; }
+
+    return (targetX - below) <= (above - targetX) ? below : above;
+}
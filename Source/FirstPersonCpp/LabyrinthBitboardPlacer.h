@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthBitPlane.h"
+
+/**
+ * Finds room positions by working on whole 64 cell words of an occupancy bit plane.
+ * For each row it ORs the rows a room would cover, then shifts and ANDs the free bits so that bit x stays set
+ * only if the room fits with its minimum corner at x. Every x offset in a word is tested by the same few instructions.
+ */
+class FIRSTPERSONCPP_API FLabyrinthBitboardPlacer
+{
+public:
+	// Find the position nearest target where a room of the given size covers no blocked cell, nor any of the last
+	// edgeMargin rows and columns of the plane. Returns false only when the room fits nowhere.
+	bool FindNearestFit(const FLabyrinthBitPlane& blocked, FIntVector2 roomSize, FIntVector2 target, FIntVector2& outCell, int32 edgeMargin = 0);
+
+	SIZE_T GetAllocatedSize() const { return FitMask.GetAllocatedSize() + Shifted.GetAllocatedSize(); }
+
+private:
+	// Fill FitMask with the x positions in row y where the room fits without covering a cell at or past usableWidth.
+	void BuildFitMask(const FLabyrinthBitPlane& blocked, int32 y, FIntVector2 roomSize, int32 usableWidth);
+
+	// Shift a row of words towards bit zero, carrying bits down from the following word.
+	static void ShiftRowDown(TConstArrayView<uint64> source, int32 shift, TArrayView<uint64> destination);
+
+	// x of the set bit nearest targetX, or INDEX_NONE if no bit is set.
+	static int32 FindNearestBit(TConstArrayView<uint64> mask, int32 targetX);
+
+	TArray<uint64> FitMask;
+	TArray<uint64> Shifted;
+};
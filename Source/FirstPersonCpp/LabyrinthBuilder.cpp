@@ -3,16 +3,28 @@
 
 #include "LabyrinthBuilder.h"
 
+#include "Net/UnrealNetwork.h"
+
 // Sets default values
 ALabyrinthBuilder::ALabyrinthBuilder()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = false;
 
+	// Only the build settings replicate. Every client spawns its own copy of the labyrinth.
+	bReplicates = true;
+	bAlwaysRelevant = true;
+
 	BillboardComponent = CreateDefaultSubobject<UBillboardComponent>(TEXT("MyBillboardComponent"));
 	RootComponent = BillboardComponent;
 
 	LabyrinthBuilderComponent = CreateDefaultSubobject<ULabyrinthBuilderComponent>(TEXT("Labyrinth Builder"));
+
+	HallFloorInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("Hall Floor Instances"));
+	HallFloorInstances->SetupAttachment(RootComponent);
+
+	HallWallInstances = CreateDefaultSubobject<UHierarchicalInstancedStaticMeshComponent>(TEXT("Hall Wall Instances"));
+	HallWallInstances->SetupAttachment(RootComponent);
 }
 
 // Called when the game starts or when spawned
@@ -28,3 +40,21 @@ void ALabyrinthBuilder::Tick(float DeltaTime)
 
 }
 
+void ALabyrinthBuilder::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ALabyrinthBuilder, ReplicatedBuildSettings);
+}
+
+void ALabyrinthBuilder::OnRep_ReplicatedBuildSettings()
+{
+	// Settings that arrive before begin play are picked up by the component's BeginPlay.
+	if (!HasActorBegunPlay() || ReplicatedBuildSettings.BuildId == 0)
+	{
+		return;
+	}
+
+	LabyrinthBuilderComponent->BuildFromSettings(ReplicatedBuildSettings);
+}
+
@@ -6,6 +6,7 @@
 #include "GameFramework/Actor.h"
 
 #include "Components/BillboardComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
 
 #include "LabyrinthBuilderComponent.h"
 
@@ -28,9 +29,28 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Seed and parameters of the server's latest build. Clients regenerate the labyrinth from these,
+	// so the spawned rooms, doors and hallways do not need to replicate.
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedBuildSettings, BlueprintReadOnly, Category = "Labyrinth Builder")
+	FLabyrinthBuildSettings ReplicatedBuildSettings;
+
 	UPROPERTY(EditAnywhere);
 	ULabyrinthBuilderComponent* LabyrinthBuilderComponent;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
 	UBillboardComponent* BillboardComponent;
+
+	// Hall floors when the builder renders hallways as instances.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UHierarchicalInstancedStaticMeshComponent* HallFloorInstances;
+
+	// Hall walls when the builder renders hallways as instances.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UHierarchicalInstancedStaticMeshComponent* HallWallInstances;
+
+private:
+	UFUNCTION()
+	void OnRep_ReplicatedBuildSettings();
 };
@@ -2,626 +2,562 @@
 
 #include "LabyrinthBuilderComponent.h"
 
-#include "Components/StaticMeshComponent.h"
+#include "Async/Async.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Engine/StaticMesh.h"
-#include "Engine/StaticMeshActor.h"
-#include "Kismet/KismetMathLibrary.h"
+#include "GameFramework/Pawn.h"
+#include "JsonObjectConverter.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Tasks/Task.h"
 
-#include "Math/Vector2D.h"
+#include "LabyrinthBuilder.h"
+#include "LabyrinthDebug.h"
+#include "LabyrinthLayoutFile.h"
+#include "LabyrinthStats.h"
 
 // Sets default values for this component's properties
 ULabyrinthBuilderComponent::ULabyrinthBuilderComponent()
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = false;
+	PrimaryComponentTick.bCanEverTick = true;
+
+	// Only ticks while spawning is spread over several frames.
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 }
 
-void ULabyrinthBuilderComponent::BuildLabyrinth()
+FLabyrinthBuildStats ULabyrinthBuilderComponent::BuildLabyrinth()
 {
-    Converter = CellUnitConverter(CellUnit);
-
-    ZeroDistanceCoordinates.Empty();
+    TRACE_CPUPROFILER_EVENT_SCOPE(Labyrinth_BuildLabyrinth);
 
-    DistanceField = TArray<TArray<int>>();
-    DistanceField.Empty();
-    DistanceField.Init(TArray<int>(), LabyrinthDimensions.Y);
-    for (int y = 0; y < LabyrinthDimensions.Y; y++)
+    if (IsBuildInProgress())
     {
-        DistanceField[y].Init(DISTANCE_FIELD_UNCALCULATED, LabyrinthDimensions.X);
+        UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder is already building a labyrinth"));
+        return FLabyrinthBuildStats{};
     }
 
-    SpawnedRooms.Empty();
-	
-    if (NumberOfRoomsToSpawn < 1)
+    LastBuildStats = FLabyrinthBuildStats{};
+
+    if (BuildFromPrebuiltLayout())
     {
-        UE_LOG(LogTemp, Log, TEXT("Tried to build labyrinth with %i rooms"), NumberOfRoomsToSpawn);
-        return;
+        return LastBuildStats;
     }
 
-    // Set up random number generator
-    if (UseExplicitRandomSeed)
+    FLabyrinthLayoutParams params{};
+    if (!PrepareBuild(params))
     {
-        RandomStream.Initialize(ExplicitRandomSeed);
-        UE_LOG(LogTemp, Log, TEXT("Using explicit random seed %i"), ExplicitRandomSeed);
+        return LastBuildStats;
     }
-    else
+
+    if (!LayoutGenerator->Generate(params, Layout))
     {
-        RandomStream.GenerateNewSeed();
-        UE_LOG(LogTemp, Log, TEXT("Using generated random seed %i"), RandomStream.GetCurrentSeed());
+        return LastBuildStats;
     }
 
-    SpawnRooms();
-
-    SpawnDoorwayPrefabs();
+    FinishBuild();
 
-    SpawnHallwayWalls();
-
-    DebugTempLogDistanceField();
-}
-
-
-// Called when the game starts
-void ULabyrinthBuilderComponent::BeginPlay()
-{
-	Super::BeginPlay();
-
-	
-	if (BuildOnBeginPlay)
-	{
-		BuildLabyrinth();
-	}
+    return LastBuildStats;
 }
 
-
-
-AActor* ULabyrinthBuilderComponent::SpawnUClass(TSubclassOf<AActor> actor, FIntVector2 cell, FRotator spawnRotation, AActor* parent)
+void ULabyrinthBuilderComponent::BuildLabyrinthAsync()
 {
-    AActor* Owner = GetOwner();
-
-    FActorSpawnParameters SpawnParameters{};
-    SpawnParameters.Owner = Owner;
-
-    FVector SpawnLocation = FVector(
-        Converter.CellToMeters(cell.X),
-        Converter.CellToMeters(cell.Y),
-        0);
-
-    if (actor)
+    // Loading a layout file is cheap enough to do on the game thread.
+    if (BuildFromPrebuiltLayout())
     {
-        return SpawnUClass(actor, SpawnLocation, spawnRotation, parent);
+        return;
     }
 
-    return nullptr;
-}
-
-AActor* ULabyrinthBuilderComponent::SpawnUClass(TSubclassOf<AActor> actor, FVector spawnLocation, FRotator spawnRotation, AActor* parent)
-{
-    AActor* Owner = GetOwner();
-
-    FActorSpawnParameters SpawnParameters{};
-    SpawnParameters.Owner = Owner;
-
-    if (actor)
+    FLabyrinthLayoutParams params{};
+    if (!PrepareBuild(params))
     {
-        AActor* newActor = GetWorld()->SpawnActor<AActor>(actor, spawnLocation, spawnRotation, SpawnParameters);
-        newActor->AttachToActor(parent, FAttachmentTransformRules::KeepRelativeTransform);
-        return newActor;
+        return;
     }
 
-    return nullptr;
-}
+    TSharedPtr<std::atomic<bool>> cancelled = MakeShared<std::atomic<bool>>(false);
+    AsyncBuildCancelled = cancelled;
 
-void ULabyrinthBuilderComponent::SpawnRooms()
-{
-    SpawnFirstRoom();
-    RecalculateDistanceField();
+    TWeakObjectPtr<ULabyrinthBuilderComponent> weakThis{ this };
+    TSharedRef<FLabyrinthLayoutGenerator> generator = LayoutGenerator;
 
-    FIntVector2 center{ LabyrinthDimensions.X / 2, LabyrinthDimensions.Y / 2 };
-    int numToSpawn{ NumberOfRoomsToSpawn - 1 };
-
-    while (numToSpawn > 0)
+    UE::Tasks::Launch(UE_SOURCE_LOCATION, [weakThis, generator, cancelled, params = MoveTemp(params)]()
     {
-        // Pick a random direction
-        FVector2D direction{
-            FMath::FRandRange(-1.0, 1.0) ,
-            FMath::FRandRange(-1.0, 1.0) };
-
-        // Find an open space.
-        // Start at center and move in the chosen direction looking for enough space for the new room.
-        int roomsizeX = Converter.MetersToCellRound(Room.GetDefaultObject()->RoomComponent->DimensionX);
-        int roomsizeY = Converter.MetersToCellRound(Room.GetDefaultObject()->RoomComponent->DimensionY);
-
-        FVector2D potentialRoomPosition{
-            Converter.CellToMeters(center.X),
-            Converter.CellToMeters(center.Y)
-        };
+        TSharedRef<FLabyrinthLayout> layout = MakeShared<FLabyrinthLayout>();
+        bool generated = generator->Generate(params, *layout, cancelled.Get());
 
-        FIntVector2 potentialRoomCoordinates{ center.X, center.Y };
-        bool foundSpawn{ false };
-
-        // Search for open space along the search path until:
-        // 1. we find open space or
-        // 2. we hit the edge.
-        while (AreRoomExtentsWithinLabyrinth(potentialRoomCoordinates, roomsizeX, roomsizeY))
+        // Spawning has to happen on the game thread.
+        AsyncTask(ENamedThreads::GameThread, [weakThis, cancelled, generated, layout]()
         {
-            bool roomPositionValid = true;
-
-            // if we find overlap, increment our distance and continue
-            for (int y = 0; y < roomsizeY; y++)
+            ULabyrinthBuilderComponent* builder = weakThis.Get();
+            if (!builder || cancelled->load() || builder->AsyncBuildCancelled != cancelled)
             {
-                if (!roomPositionValid) { break; }
-
-                for (int x = 0; x < roomsizeX; x++)
-                {
-                    int cellValue = DistanceField[potentialRoomCoordinates.Y + y][potentialRoomCoordinates.X + x];
-                    if (cellValue == DISTANCE_FIELD_ROOM || cellValue <= 0)
-                    {
-                        potentialRoomPosition = NextCoordinateAlongSearchPath(potentialRoomPosition, direction);
-                        potentialRoomCoordinates = FIntVector2(
-                            Converter.MetersToCellFloor(potentialRoomPosition.X),
-                            Converter.MetersToCellFloor(potentialRoomPosition.Y));
-
-                        // break out to while loop
-                        roomPositionValid = false;
-                        break;
-                    }
-                }
+                return;
             }
 
-            // otherwise, we have found our spawn position
-            if (roomPositionValid)
-            {
-                foundSpawn = true;
-                break;
-            }
-        }
-
-        if (!foundSpawn)
-        {
-            UE_LOG(LogTemp, Log, TEXT("LabyrinthBuilder could not spawn a room along a search path! Trying a new path."));
-            continue; // try again
-        }
-        else
-        {
-            numToSpawn--;
-        }
-
-        ARoom* newRoom = SpawnRoom(potentialRoomCoordinates);
-
-        ConnectToExistingRooms(potentialRoomCoordinates, newRoom);
-
-        AddRoomDoorsToDistanceField(potentialRoomCoordinates);
-
-        // Update distance field
-        RecalculateDistanceField();
-    }
+            builder->OnAsyncLayoutGenerated(generated, layout);
+        });
+    });
 }
 
-void ULabyrinthBuilderComponent::SpawnFirstRoom()
+void ULabyrinthBuilderComponent::OnAsyncLayoutGenerated(bool generated, TSharedRef<FLabyrinthLayout> layout)
 {
-    FVector roomWorldSpaceDimensions{ Room.GetDefaultObject()->RoomComponent->DimensionX, Room.GetDefaultObject()->RoomComponent->DimensionY, 0 };
-    FIntVector2 roomCellDimensions{ Converter.MetersToCellRound(roomWorldSpaceDimensions.X), Converter.MetersToCellRound(roomWorldSpaceDimensions.Y) };
+    AsyncBuildCancelled.Reset();
 
-    FIntVector2 roomSpawnCell
+    if (!generated)
     {
-        (LabyrinthDimensions.X / 2) - (roomCellDimensions.X / 2),
-        (LabyrinthDimensions.Y / 2) - (roomCellDimensions.Y / 2)
-    };
+        LastBuildStats = FLabyrinthBuildStats{};
+        BuildPendingSettings();
+        return;
+    }
 
-    SpawnRoom(roomSpawnCell);
+    Layout = MoveTemp(*layout);
 
-    AddRoomDoorsToDistanceField(roomSpawnCell);
+    FinishBuild();
 }
 
-/// <summary>
-/// Spawn a room at the given location, which is the x, y minimum extent of the room.
-/// </summary>
-/// <param name="cell"></param>
-ARoom* ULabyrinthBuilderComponent::SpawnRoom(FIntVector2 cell)
+bool ULabyrinthBuilderComponent::PrepareBuild(FLabyrinthLayoutParams& outParams)
 {
-    AActor* Owner = GetOwner();
-
-    FActorSpawnParameters SpawnParameters{};
-    SpawnParameters.Owner = Owner;
+    if (IsBuildInProgress())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder is already building a labyrinth"));
+        return false;
+    }
 
-    ARoom* SpawnedRoom = nullptr;
+    if (NumberOfRoomsToSpawn < 1)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Tried to build labyrinth with %i rooms"), NumberOfRoomsToSpawn);
+        return false;
+    }
 
-    if (Room)
+    if (!Room)
     {
-        FVector SpawnLocation = FVector(
-            Converter.CellToMeters(cell.X),
-            Converter.CellToMeters(cell.Y),
-            0);
-        FRotator SpawnRotation = Owner->GetActorRotation();
+        UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder has no Room class to build with"));
+        return false;
+    }
 
-        SpawnedRoom = GetWorld()->SpawnActor<ARoom>(Room, SpawnLocation, SpawnRotation, SpawnParameters);
-        SpawnedRoom->AttachToActor(Owner, FAttachmentTransformRules::KeepRelativeTransform);
-    
-        SpawnedRooms.Add(SpawnedRoom);
+    // Set up random number generator
+    if (UseExplicitRandomSeed)
+    {
+        RandomStream.Initialize(ExplicitRandomSeed);
+        UE_LOG(LogTemp, Log, TEXT("Using explicit random seed %i"), ExplicitRandomSeed);
     }
+    else
+    {
+        RandomStream.GenerateNewSeed();
+        UE_LOG(LogTemp, Log, TEXT("Using generated random seed %i"), RandomStream.GetCurrentSeed());
+    }
+
+    outParams = MakeLayoutParams(RandomStream.GetCurrentSeed());
 
-    AddRoomToDistanceField(cell);
+    PublishBuildSettings(outParams);
 
-    return SpawnedRoom;
+    return true;
 }
 
-void ULabyrinthBuilderComponent::AddRoomToDistanceField(FIntVector2 cell)
+bool ULabyrinthBuilderComponent::BuildFromPrebuiltLayout()
 {
-    FVector roomWorldSpaceDimensions{ Room.GetDefaultObject()->RoomComponent->DimensionX, Room.GetDefaultObject()->RoomComponent->DimensionY, 0};
-    FIntVector2 roomCellDimensions{ Converter.MetersToCellRound(roomWorldSpaceDimensions.X), Converter.MetersToCellRound(roomWorldSpaceDimensions.Y) };
+    if (PrebuiltLayoutFile.FilePath.IsEmpty())
+    {
+        return false;
+    }
 
-    // Make room tiles distance max int. Max int denotes not passable.
-    for (int y = 0; y < roomCellDimensions.Y; y++)
+    if (IsBuildInProgress())
     {
-        for (int x = 0; x < roomCellDimensions.X; x++)
-        {
-            int currentRoomX = cell.X + x;
-            int currentRoomY = cell.Y + y;
-            DistanceField[currentRoomY][currentRoomX] = DISTANCE_FIELD_ROOM;
-        }
+        UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder is already building a labyrinth"));
+        return true;
     }
-}
 
-void ULabyrinthBuilderComponent::AddRoomDoorsToDistanceField(FIntVector2 cell)
-{
-    // Mark the space outside each door as a potential door.
-    for (const FTransform& door : Room.GetDefaultObject()->RoomComponent->Doors)
+    if (!Room)
     {
-        FIntVector2 doorCoordinate{ FindDoorCoordinate(cell, door) };
+        UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder has no Room class to build with"));
+        return true;
+    }
 
-        // Make sure we are still in the array and not overriding a room
-        if (!IsInDistanceField(doorCoordinate) || DistanceField[doorCoordinate.Y][doorCoordinate.X] == DISTANCE_FIELD_ROOM)
-        {
-            continue;
-        }
+    FString path{ FPaths::Combine(FPaths::ProjectContentDir(), PrebuiltLayoutFile.FilePath) };
 
-        // Make that coordinate 0 in the distance field
-        SetPotentialDoorCell(doorCoordinate);
+    FLabyrinthLayoutFile layoutFile;
+    if (!layoutFile.Open(path, VerifyPrebuiltLayoutChecksums))
+    {
+        return true;
     }
-}
 
-FIntVector2 ULabyrinthBuilderComponent::FindDoorCoordinate(FIntVector2 roomCell, FTransform door)
-{
-    // Move door position forward into an adjoining cell.
-        // The provided position is the door prefab spawn position.
-        // The forward direction of the provided transform indicates "out of the room"
-        // Adding half of a unit also accounts for float precision.
-    FVector doorPosition = door.GetLocation();
-    FVector hallPosition = FVector{ doorPosition.X, doorPosition.Y, doorPosition.Z };
-    FVector doorForward3{ door.GetRotation().GetForwardVector() };
-    FVector2D doorForward{ doorForward3.X, doorForward3.Y };
-    hallPosition = hallPosition + ((FVector{ doorForward.X, doorForward.Y, 0 } * CellUnit * 0.5f));
-
-    // Translate to coordinate in grid
-    int doorX{ roomCell.X + Converter.MetersToCellFloor(hallPosition.X) };
-
-    int doorY{ roomCell.Y + Converter.MetersToCellFloor(hallPosition.Y) };
-
-    return FIntVector2{ doorX, doorY };
-}
+    const FLabyrinthLayoutFileHeader& header = layoutFile.GetHeader();
 
-bool ULabyrinthBuilderComponent::IsInDistanceField(FIntVector2 cell)
-{
-    return
-        (cell.X >= 0) &&
-        (cell.Y >= 0) &&
-        (cell.X < LabyrinthDimensions.X) &&
-        (cell.Y < LabyrinthDimensions.Y);
-}
+    // The room class decides door placement, so it has to match the rooms the file was generated with.
+    FLabyrinthLayoutParams params{ MakeLayoutParams(header.Seed) };
+    if (params.RoomCellSize != header.RoomCellSize)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Labyrinth layout file %s has %i x %i cell rooms but the Room class is %i x %i cells"),
+            *path, header.RoomCellSize.X, header.RoomCellSize.Y, params.RoomCellSize.X, params.RoomCellSize.Y);
+        return true;
+    }
 
-bool ULabyrinthBuilderComponent::AreRoomExtentsWithinLabyrinth(FIntVector2 position, int sizeX, int sizeY)
-{
-    return
-        IsInDistanceField(position + FIntVector2{ 0, sizeY }) &&
-        IsInDistanceField(position) &&
-        IsInDistanceField(position + FIntVector2{ sizeX, 0 }) &&
-        IsInDistanceField(position + FIntVector2{ sizeX, sizeY });
+    UE_LOG(LogTemp, Log, TEXT("LabyrinthBuilder loaded layout %s (%s)"), *path, layoutFile.IsMapped() ? TEXT("mapped") : TEXT("read"));
+
+    layoutFile.CopyToLayout(Layout, params.RoomDoors);
+
+    params.Dimensions = header.Dimensions;
+    params.NumberOfRooms = header.NumRooms;
+    params.CellUnit = header.CellUnit;
+    PublishBuildSettings(params);
+
+    FinishBuild(true);
+    return true;
 }
 
-void ULabyrinthBuilderComponent::SetPotentialDoorCell(FIntVector2 cell)
+bool ULabyrinthBuilderComponent::AppendBuildStatsToFile(const FString& path) const
 {
-    // If cell not found in zeroDistanceCoordinates cache
-    if (!ZeroDistanceCoordinates.Contains(cell))
+    FString json;
+    if (!FJsonObjectConverter::UStructToJsonObjectString(LastBuildStats, json, 0, 0, 0, nullptr, false))
     {
-        DistanceField[cell.Y][cell.X] = DISTANCE_FIELD_POTENTIAL_DOOR;
-
-        ZeroDistanceCoordinates.Add(cell);
+        return false;
     }
-}
 
-void ULabyrinthBuilderComponent::SetHallwayCell(FIntVector2 cell)
-{
-    // hall overrides potential door. Always set this.
-    DistanceField[cell.Y][cell.X] = DISTANCE_FIELD_HALL;
+    json += LINE_TERMINATOR;
 
-    FIntVector2 coordinate{ cell.X, cell.Y };
-    if (!ZeroDistanceCoordinates.Contains(coordinate))
+    if (!FFileHelper::SaveStringToFile(json, *path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
     {
-        ZeroDistanceCoordinates.Add(coordinate);
+        UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder could not write build stats to %s"), *path);
+        return false;
     }
+
+    return true;
 }
 
-FVector2D ULabyrinthBuilderComponent::NextCoordinateAlongSearchPath(FVector2D currentposition, FVector2D searchDirection)
+bool ULabyrinthBuilderComponent::SaveLayoutToFile(const FString& path) const
 {
-    double nextX, nextY;
-
-    if (searchDirection.X > 0)
+    if (Layout.Rooms.IsEmpty())
     {
-        nextX = currentposition.X + CellUnit;
+        UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder has no layout to save"));
+        return false;
     }
-    else
+
+    return FLabyrinthLayoutFile::Save(Layout, path);
+}
+
+void ULabyrinthBuilderComponent::BuildFromSettings(const FLabyrinthBuildSettings& settings)
+{
+    if (IsBuildInProgress())
     {
-        nextX = currentposition.X - CellUnit;
+        UE_LOG(LogTemp, Log, TEXT("LabyrinthBuilder received build %i during another build and will start it once that one finishes"), settings.BuildId);
+        PendingBuildSettings = settings;
+        return;
     }
 
-    if (searchDirection.Y > 0)
+    UseExplicitRandomSeed = true;
+    ExplicitRandomSeed = settings.Seed;
+    LabyrinthDimensions = settings.Dimensions;
+    NumberOfRoomsToSpawn = settings.NumberOfRooms;
+    CellUnit = settings.CellUnit;
+    MergeHallwayWalls = settings.MergeHallwayWalls;
+    PlacementStrategy = settings.PlacementStrategy;
+    NumCandidateRays = settings.NumCandidateRays;
+    RoomBatchSize = settings.RoomBatchSize;
+
+    if (BuildAsynchronously)
     {
-        nextY = currentposition.Y + CellUnit;
+        BuildLabyrinthAsync();
     }
     else
     {
-        nextY = currentposition.Y - CellUnit;
+        BuildLabyrinth();
     }
+}
 
-    // Use z = mx + b to fill in missing values.
-    // m: slope
-    // b: z such that x = 0
-    double slope = searchDirection.Y / searchDirection.X;
-    double yIntercept = currentposition.Y - (slope * currentposition.X); // b = z - (m * x)
-    FVector2D targetInterceptX = FVector2D{
-        nextX,
-        (slope * nextX) + yIntercept // y = (m * x) + b
-    };
-    FVector2D targetInterceptZ = FVector2D{
-        (nextY - yIntercept) / slope, // x = (y - b) / m
-        nextY
-    };
-
-    // Choose closest candidate as new currentPosition
-    if (FVector2D::DistSquared(currentposition, targetInterceptX) < FVector2D::DistSquared(currentposition, targetInterceptZ))
-    {
-        return targetInterceptX;
-    }
-    else
+void ULabyrinthBuilderComponent::BuildPendingSettings()
+{
+    if (!PendingBuildSettings.IsSet())
     {
-        return targetInterceptZ;
+        return;
     }
+
+    FLabyrinthBuildSettings settings{ PendingBuildSettings.GetValue() };
+    PendingBuildSettings.Reset();
+
+    BuildFromSettings(settings);
 }
 
-void ULabyrinthBuilderComponent::ConnectToExistingRooms(FIntVector2 roomSpawnCoordinate, ARoom* room)
+bool ULabyrinthBuilderComponent::IsReplicatedClient() const
 {
-    TArray<FTransform> doors = room->RoomComponent->Doors;
-    if (doors.IsEmpty()) { return; }
-
-    FIntVector2 minimumDistanceDoor{};
-    int currentMinimumDistance{ std::numeric_limits<int>::max() };
+    const ALabyrinthBuilder* builder = Cast<ALabyrinthBuilder>(GetOwner());
+    return builder && builder->GetIsReplicated() && !builder->HasAuthority();
+}
 
-    // pick a door to connect based on minimum distance in distance field
-    for (const FTransform& door : doors)
+void ULabyrinthBuilderComponent::PublishBuildSettings(const FLabyrinthLayoutParams& params)
+{
+    ALabyrinthBuilder* builder = Cast<ALabyrinthBuilder>(GetOwner());
+    if (!builder || !builder->GetIsReplicated() || !builder->HasAuthority())
     {
-        FIntVector2 doorCoordinates = FindDoorCoordinate(roomSpawnCoordinate, door);
-        int currentDistance{ DistanceField[doorCoordinates.Y][doorCoordinates.X] };
+        return;
+    }
 
-        if (IsInDistanceField(doorCoordinates) &&
-            currentDistance < currentMinimumDistance)
-        {
-            currentMinimumDistance = currentDistance;
-            minimumDistanceDoor = doorCoordinates;
-        }
+    FLabyrinthBuildSettings settings{};
+    settings.Seed = params.Seed;
+    settings.Dimensions = params.Dimensions;
+    settings.NumberOfRooms = params.NumberOfRooms;
+    settings.CellUnit = params.CellUnit;
+    settings.MergeHallwayWalls = params.bMergeHallwayWalls;
+    settings.PlacementStrategy = params.PlacementStrategy;
+    settings.NumCandidateRays = params.NumCandidateRays;
+    settings.RoomBatchSize = params.RoomBatchSize;
+    settings.BuildId = builder->ReplicatedBuildSettings.BuildId + 1;
+
+    builder->ReplicatedBuildSettings = settings;
+    builder->ForceNetUpdate();
+}
+
+void ULabyrinthBuilderComponent::FinishBuild(bool loadedFromFile)
+{
+    UE_LOG(LogTemp, Log, TEXT("LabyrinthBuilder layout hash %08x for seed %i"), Layout.ComputeHash(), Layout.Seed);
+
+    LastBuildStats = FLabyrinthBuildStats{};
+    LastBuildStats.Succeeded = true;
+    LastBuildStats.LoadedFromFile = loadedFromFile;
+    LastBuildStats.Seed = Layout.Seed;
+    LastBuildStats.Dimensions = Layout.Dimensions;
+    LastBuildStats.RoomsPlaced = Layout.Rooms.Num();
+    LastBuildStats.HallCells = Layout.HallCells.Num();
+    LastBuildStats.WallFaces = Layout.NumWallFaces;
+    LastBuildStats.WallPieces = Layout.WallRuns.Num();
+
+    if (!loadedFromFile)
+    {
+        const FLabyrinthGenerationStats& generation = LayoutGenerator->GetStats();
+        LastBuildStats.PlacementRetries = generation.NumFailedSearchPaths;
+        LastBuildStats.UnconnectedRooms = generation.NumUnconnectedRooms;
+        LastBuildStats.SearchPathSteps = generation.NumSearchPathSteps;
+        LastBuildStats.DistanceFieldVisits = generation.NumCellsVisited;
+        LastBuildStats.RoomPlacementMs = generation.RoomPlacementSeconds * 1000.0;
+        LastBuildStats.DistanceFieldMs = generation.DistanceFieldSeconds * 1000.0;
+        LastBuildStats.CorridorMs = generation.CorridorSeconds * 1000.0;
+        LastBuildStats.DoorMs = generation.DoorSeconds * 1000.0;
+        LastBuildStats.WallMs = generation.WallSeconds * 1000.0;
+        LastBuildStats.GenerationMs = generation.TotalSeconds * 1000.0;
+        LastBuildStats.GridBytes = generation.AllocatedBytes;
+        LastBuildStats.ScratchAllocations = generation.NumScratchAllocations;
     }
 
-    FIntVector2 currentPathLocation = minimumDistanceDoor;
+    double materializeStart{ FPlatformTime::Seconds() };
 
-    TArray<FIntVector2> path{};
-    path.Add(currentPathLocation);
+    Materializer.Begin(Layout, MakeMaterializerSettings());
 
-    while (DistanceField[currentPathLocation.Y][currentPathLocation.X] > 0)
+    if (TimeSliceMaterialization)
     {
-        // look in all directions for minimum distance. set that as new current location.
-        FIntVector2 minimumDistanceCell{};
-        int currentMinimumCellDistance{ std::numeric_limits<int>::max() };
-
-        for (FIntVector2 direction : TraversalDirections)
+        APawn* playerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+        if (playerPawn)
         {
-            FIntVector2 cellCoord{ currentPathLocation + direction };
-            int cellValue{ DistanceField[cellCoord.Y][cellCoord.X] };
-
-            if (cellValue < currentMinimumCellDistance)
-            {
-                currentMinimumCellDistance = cellValue;
-                minimumDistanceCell = cellCoord;
-            }
+            Materializer.SortByDistanceTo(GetOwner()->GetActorTransform().InverseTransformPosition(playerPawn->GetActorLocation()));
         }
 
-        currentPathLocation = minimumDistanceCell;
-        path.Add(currentPathLocation);
+        IsMaterializing = true;
+        SetComponentTickEnabled(true);
+        LastBuildStats.MaterializationMs += (FPlatformTime::Seconds() - materializeStart) * 1000.0;
+        return;
     }
 
-    AActor* Owner = GetOwner();
-    for (FIntVector2 cell : path)
-    {
-        if (DistanceField[cell.Y][cell.X] != DISTANCE_FIELD_HALL)
-        {
-            // spawn hall floor
-            SpawnUClass(HallFloorCeilingBlueprint, cell, Owner->GetActorRotation(), Owner);
+    Materializer.SpawnAll();
+    LastBuildStats.MaterializationMs += (FPlatformTime::Seconds() - materializeStart) * 1000.0;
 
-            SetHallwayCell(cell);
-        }
-    }
+    FinishMaterialization();
 }
 
-void ULabyrinthBuilderComponent::RecalculateDistanceField()
+void ULabyrinthBuilderComponent::FinishMaterialization()
 {
-    // Check all zero distance coordinates for recalculation of neighbors
-    TQueue<FIntVector2> toCheck{};
-    for (FIntVector2 coordinate : ZeroDistanceCoordinates)
-    {
-        toCheck.Enqueue(coordinate);
-    }
+    IsMaterializing = false;
+    SetComponentTickEnabled(false);
 
-    while (!toCheck.IsEmpty())
-    {
-        FIntVector2 currentCoordinate{ *toCheck.Peek()};
-        toCheck.Pop();
+    UE_LOG(LogTemp, Log, TEXT("LabyrinthBuilder spawned %i actors and %i instances"), Materializer.GetNumActorsSpawned(), Materializer.GetNumInstancesAdded());
 
-        int currentCoordinateDistance = DistanceField[currentCoordinate.Y][currentCoordinate.X];
+    LastBuildStats.ActorsSpawned = Materializer.GetNumActorsSpawned();
+    LastBuildStats.InstancesAdded = Materializer.GetNumInstancesAdded();
 
-        // max(currentCoordinateDistance, 0) to handle sentinel values.
-        if (currentCoordinateDistance < 0) { currentCoordinateDistance = 0; }
+    if (WriteBuildStats)
+    {
+        AppendBuildStatsToFile(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Labyrinths"), TEXT("BuildStats.jsonl")));
+    }
 
-        // Check each direction. If a neighbor cell needs a value, update and queue it. Otherwise move to the next cell.
-        for (FIntVector2 direction : TraversalDirections)
-        {
-            FIntVector2 cellToCheck = currentCoordinate + direction;
+#if !UE_BUILD_SHIPPING
+    if (LabyrinthDebug::IsDistanceFieldLogEnabled() && CanReadDistanceField())
+    {
+        LabyrinthDebug::LogDistanceField(LayoutGenerator->GetDistanceField());
+    }
+#endif
 
-            if (!IsInDistanceField(cellToCheck))
-            {
-                continue;
-            }
+    OnLabyrinthBuilt.Broadcast();
 
-            if (DistanceField[cellToCheck.Y][cellToCheck.X] != DISTANCE_FIELD_ROOM
-                && DistanceField[cellToCheck.Y][cellToCheck.X] > currentCoordinateDistance + 1)
-            {
-                DistanceField[cellToCheck.Y][cellToCheck.X] = currentCoordinateDistance + 1;
-                toCheck.Enqueue(cellToCheck);
-            }
-        }
-    }
+    BuildPendingSettings();
 }
 
-void ULabyrinthBuilderComponent::SpawnDoorwayPrefabs()
+
+// Called when the game starts
+void ULabyrinthBuilderComponent::BeginPlay()
 {
-    for (ARoom * room : SpawnedRooms)
-    {
+	Super::BeginPlay();
 
-        for (FTransform door : room->RoomComponent->Doors)
-        {
-            FVector doorLocation = door.GetLocation();
+	// Clients build from the server's replicated settings instead of their own.
+	if (IsReplicatedClient())
+	{
+		const ALabyrinthBuilder* builder = Cast<ALabyrinthBuilder>(GetOwner());
+		if (builder->ReplicatedBuildSettings.BuildId != 0)
+		{
+			BuildFromSettings(builder->ReplicatedBuildSettings);
+		}
+		return;
+	}
 
-            FVector roomRelativeLocation{ room->GetRootComponent()->GetRelativeLocation() };
-            FIntVector2 roomCell{
-                Converter.MetersToCellFloor(roomRelativeLocation.X),
-                Converter.MetersToCellFloor(roomRelativeLocation.Y)
-            };
+	if (BuildOnBeginPlay)
+	{
+		if (BuildAsynchronously)
+		{
+			BuildLabyrinthAsync();
+		}
+		else
+		{
+			BuildLabyrinth();
+		}
+	}
+}
 
-            FIntVector2 doorCoordinate{ FindDoorCoordinate(roomCell, door) };
+void ULabyrinthBuilderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Stop an in flight build. The worker notices the flag and the game thread continuation is dropped.
+	if (AsyncBuildCancelled.IsValid())
+	{
+		AsyncBuildCancelled->store(true);
+		AsyncBuildCancelled.Reset();
+	}
 
-            FRotator doorForward{ door.GetRotation() };
+	// Pieces not spawned yet are dropped.
+	IsMaterializing = false;
+	PendingBuildSettings.Reset();
 
-            if (DistanceField[doorCoordinate.Y][doorCoordinate.X] == DISTANCE_FIELD_HALL)
-            {
-                SpawnUClass(DoorOpenBlueprint, doorLocation, doorForward, room);
-            }
-            else
-            {
-                SpawnUClass(DoorClosedBlueprint, doorLocation, doorForward, room);
-            }
-        }
-    }
+	Super::EndPlay(EndPlayReason);
 }
 
-void ULabyrinthBuilderComponent::SpawnHallwayWalls()
+void ULabyrinthBuilderComponent::ApplyRoomDefaults(TSubclassOf<ARoom> room, FLabyrinthLayoutParams& params)
 {
-    for (FIntVector2 hallCell : ZeroDistanceCoordinates)
-    {
-        if (DistanceField[hallCell.Y][hallCell.X] != DISTANCE_FIELD_HALL)
-        {
-            continue;
-        }
+    CellUnitConverter converter{ params.CellUnit };
+    const URoomComponent* roomDefaults = room.GetDefaultObject()->RoomComponent;
 
-        for (FIntVector2 direction : TraversalDirections)
-        {
-            FIntVector2 adjacentCellCoordinates = hallCell + direction;
-            int adjacentCellValue = DistanceField[adjacentCellCoordinates.Y][adjacentCellCoordinates.X];
-
-            if (adjacentCellValue != DISTANCE_FIELD_HALL &&
-                adjacentCellValue != DISTANCE_FIELD_ROOM)
-            {
-                SpawnHallwayWall(hallCell, direction);
-            }
-        }
-    }
+    params.RoomCellSize = FIntVector2{ converter.MetersToCellRound(roomDefaults->DimensionX), converter.MetersToCellRound(roomDefaults->DimensionY) };
+    params.RoomDoors = roomDefaults->Doors;
 }
 
-void ULabyrinthBuilderComponent::SpawnHallwayWall(FIntVector2 hallwayCell, FIntVector2 wallDirection)
+FLabyrinthLayoutParams ULabyrinthBuilderComponent::MakeLayoutParams(int32 seed) const
 {
-    FRotator hallwayRotation{ UKismetMathLibrary::FindLookAtRotation(FVector{}, FVector(wallDirection.X, wallDirection.Y, 0)) };
-    AActor* newWall = SpawnUClass(
-        HallWallBlueprint, 
-        hallwayCell, 
-        UKismetMathLibrary::FindLookAtRotation(FVector{}, FVector(wallDirection.X, wallDirection.Y, 0)),
-        GetOwner());
+    FLabyrinthLayoutParams params{};
+    params.Seed = seed;
+    params.Dimensions = LabyrinthDimensions;
+    params.NumberOfRooms = NumberOfRoomsToSpawn;
+    params.CellUnit = CellUnit;
+    ApplyRoomDefaults(Room, params);
+    params.bIncrementalDistanceField = UseIncrementalDistanceField;
+    params.bWavefrontDistanceField = UseWavefrontDistanceField;
+    params.ParallelDistanceFieldMinCells = ParallelDistanceFieldMinCells;
+    params.bMergeHallwayWalls = MergeHallwayWalls;
+    params.PlacementStrategy = PlacementStrategy;
+    params.NumCandidateRays = FMath::Max(NumCandidateRays, 1);
+    params.RoomBatchSize = FMath::Max(RoomBatchSize, 1);
+
+    return params;
+}
 
-    if (wallDirection.X == 0 && wallDirection.Y == 1)
-    {
-        newWall->AddActorLocalOffset(FVector{0, Converter.CellToMeters(-1), 0});
-    }
-    else if (wallDirection.X == 0 && wallDirection.Y == -1)
+FLabyrinthMaterializerSettings ULabyrinthBuilderComponent::MakeMaterializerSettings()
+{
+    FLabyrinthMaterializerSettings settings{};
+    settings.Owner = GetOwner();
+    settings.Room = Room;
+    settings.DoorOpenBlueprint = DoorOpenBlueprint;
+    settings.DoorClosedBlueprint = DoorClosedBlueprint;
+    settings.HallFloorCeilingBlueprint = HallFloorCeilingBlueprint;
+    settings.HallWallBlueprint = HallWallBlueprint;
+
+    ALabyrinthBuilder* builder = Cast<ALabyrinthBuilder>(GetOwner());
+
+    // Clear instances from a previous build even if this one spawns actors.
+    if (builder)
     {
-        newWall->AddActorLocalOffset(FVector{ Converter.CellToMeters(-1), 0, 0 });
+        builder->HallFloorInstances->ClearInstances();
+        builder->HallWallInstances->ClearInstances();
     }
-    else if (wallDirection.X == -1 && wallDirection.Y == 0)
+
+    if (HallwayRenderMode != ELabyrinthHallwayRenderMode::Instances)
     {
-        newWall->AddActorLocalOffset(FVector{ Converter.CellToMeters(-1), Converter.CellToMeters(-1), 0 });
+        return settings;
     }
-    else if (wallDirection.X == 1 && wallDirection.Y == 0) {} // no op
-    else
+
+    if (!builder || !HallFloorCeilingMesh || !HallWallMesh)
     {
-        UE_LOG(LogTemp, Log, TEXT("Error! Unexpected direction found in ULabyrinthBuilderComponent::SpawnHallwayWall: %i, %i"), wallDirection.X, wallDirection.Y);
+        UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder needs an ALabyrinthBuilder owner and both hallway meshes to build instanced hallways. Spawning actors instead."));
+        return settings;
     }
-}
 
-void ULabyrinthBuilderComponent::DebugTempLogDistanceField()
-{
-    FString LogString{"Distance field:\n"};
+    builder->HallFloorInstances->SetStaticMesh(HallFloorCeilingMesh);
+    builder->HallWallInstances->SetStaticMesh(HallWallMesh);
 
-    for (int y = 0; y < LabyrinthDimensions.Y; y++)
-    {
-        // print row number
-        LogString += FString::Printf(TEXT("%02d"), y);
+    settings.HallFloorInstances = builder->HallFloorInstances;
+    settings.HallWallInstances = builder->HallWallInstances;
 
-        for (int x = 0; x < LabyrinthDimensions.X; x++)
-        {
-            // give ourselvs a visual indication of every 10 columns
-            if (x % 5 == 0)
-            {
-                LogString += TEXT(" | ");
-            }
+    return settings;
+}
 
-            int currentCellValue = DistanceField[y][x];
+UTexture2D* ULabyrinthBuilderComponent::CreateDistanceFieldTexture()
+{
+    if (!CanReadDistanceField())
+    {
+        return nullptr;
+    }
 
-            if (currentCellValue == DISTANCE_FIELD_ROOM)
-            {
-                LogString += TEXT("room  ");
-            }
-            else if (currentCellValue == DISTANCE_FIELD_UNCALCULATED)
-            {
-                LogString += TEXT("....  ");
-            }
-            else if (currentCellValue == DISTANCE_FIELD_HALL)
-            {
-                LogString += TEXT("hall  ");
-            }
-            else
-            {
-                LogString += FString::Printf(TEXT(" %02d   "), currentCellValue);
-            }
-        }
+    return LabyrinthDebug::CreateDistanceFieldTexture(LayoutGenerator->GetDistanceField(), this);
+}
 
-        // on to the next row
-        LogString += TEXT("\n");
+void ULabyrinthBuilderComponent::DrawDebugCellsNearPlayer(int32 radiusCells, float duration)
+{
+    APawn* playerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+    if (!playerPawn || !CanReadDistanceField())
+    {
+        return;
     }
 
-    UE_LOG(LogTemp, Log, TEXT("%s"), *LogString);
+    LabyrinthDebug::DrawCellsNear(GetWorld(), LayoutGenerator->GetDistanceField(), GetOwner()->GetActorTransform(),
+        Layout.CellUnit, playerPawn->GetActorLocation(), radiusCells, duration);
 }
 
+bool ULabyrinthBuilderComponent::CanReadDistanceField() const
+{
+    // The worker owns the generator during an asynchronous build, and a loaded layout never had a distance field.
+    return !AsyncBuildCancelled.IsValid() && LastBuildStats.Succeeded && !LastBuildStats.LoadedFromFile;
+}
 
 // Called every frame
 void ULabyrinthBuilderComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	// ...
+    if (!IsMaterializing)
+    {
+        SetComponentTickEnabled(false);
+        return;
+    }
+
+    TRACE_CPUPROFILER_EVENT_SCOPE(Labyrinth_SpawnTimeSlice);
+
+    // Always spawn at least one piece so a tiny budget still makes progress.
+    double sliceStart{ FPlatformTime::Seconds() };
+    double budgetEnd{ sliceStart + (MaterializationBudgetMs / 1000.0) };
+    do
+    {
+        if (!Materializer.SpawnNext()) { break; }
+    }
+    while (FPlatformTime::Seconds() < budgetEnd);
+
+    Materializer.FlushInstances();
+
+    LastBuildStats.MaterializationMs += (FPlatformTime::Seconds() - sliceStart) * 1000.0;
+
+    if (Materializer.IsFinished())
+    {
+        FinishMaterialization();
+    }
 }
 
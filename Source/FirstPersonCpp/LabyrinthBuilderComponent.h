@@ -2,16 +2,153 @@
 
 #pragma once
 
-#include <limits>
-
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 
-#include "CellUnitConverter.h"
+#include "LabyrinthLayout.h"
+#include "LabyrinthLayoutGenerator.h"
+#include "LabyrinthMaterializer.h"
 #include "Room.h"
 
 #include "LabyrinthBuilderComponent.generated.h"
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnLabyrinthBuilt);
+
+class UStaticMesh;
+class UTexture2D;
+
+/**
+ * The seed and parameters that fully determine a labyrinth.
+ * Replicated instead of the spawned actors so every client generates the same labyrinth locally.
+ */
+USTRUCT(BlueprintType)
+struct FLabyrinthBuildSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 Seed = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	FIntVector2 Dimensions = FIntVector2(40, 40);
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 NumberOfRooms = 8;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	double CellUnit = 2.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	bool MergeHallwayWalls = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	ELabyrinthPlacementStrategy PlacementStrategy = ELabyrinthPlacementStrategy::SearchRays;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 NumCandidateRays = 1;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 RoomBatchSize = 1;
+
+	// Bumped for every build so rebuilding with the same settings still replicates. Zero means nothing has been built.
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 BuildId = 0;
+};
+
+/**
+ * What one build produced and what it cost. Written as one JSON object per build for telemetry.
+ */
+USTRUCT(BlueprintType)
+struct FLabyrinthBuildStats
+{
+	GENERATED_BODY()
+
+	// False if the build was rejected or generation failed. Nothing else is filled in then.
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	bool Succeeded = false;
+
+	// Spawned from a layout file rather than generated. Generation fields stay zero.
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	bool LoadedFromFile = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 Seed = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	FIntVector2 Dimensions = FIntVector2(0, 0);
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 RoomsPlaced = 0;
+
+	// Rooms placed without a hallway to the rest of the labyrinth
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 UnconnectedRooms = 0;
+
+	// Room search paths that reached the labyrinth edge and had to be retried
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 PlacementRetries = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 SearchPathSteps = 0;
+
+	// Cells taken off the distance field frontier over every update
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int64 DistanceFieldVisits = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 HallCells = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 WallFaces = 0;
+
+	// Wall pieces after merging, equal to WallFaces when walls are not merged
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 WallPieces = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 ActorsSpawned = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 InstancesAdded = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	float RoomPlacementMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	float DistanceFieldMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	float CorridorMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	float DoorMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	float WallMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	float GenerationMs = 0.0f;
+
+	// Time spent spawning, summed over every frame when spawning is time sliced
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	float MaterializationMs = 0.0f;
+
+	// Bytes held by the generator's grids and scratch buffers at the end of generation
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int64 GridBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Labyrinth Builder")
+	int32 ScratchAllocations = 0;
+};
+
+UENUM(BlueprintType)
+enum class ELabyrinthHallwayRenderMode : uint8
+{
+	// Spawn one HallFloorCeilingBlueprint / HallWallBlueprint actor per piece.
+	Actors,
+	// Add every piece as an instance of HallFloorCeilingMesh / HallWallMesh on the owning ALabyrinthBuilder.
+	Instances
+};
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class FIRSTPERSONCPP_API ULabyrinthBuilderComponent : public UActorComponent
@@ -22,11 +159,90 @@ public:
 	// Sets default values for this component's properties
 	ULabyrinthBuilderComponent();
 
-	void BuildLabyrinth();
+	// Build and spawn a labyrinth, returning its stats. When spawning is time sliced the
+	// spawn counts and MaterializationMs are only complete once OnLabyrinthBuilt fires; see GetLastBuildStats.
+	UFUNCTION(BlueprintCallable, Category = "Labyrinth Builder")
+	FLabyrinthBuildStats BuildLabyrinth();
+
+	// Generate the layout on a worker thread, then spawn it on the game thread and broadcast OnLabyrinthBuilt.
+	// The build is cancelled if the component ends play first.
+	UFUNCTION(BlueprintCallable, Category = "Labyrinth Builder")
+	void BuildLabyrinthAsync();
+
+	// Fill in the room size and door transforms from a room class's defaults. params.CellUnit must already be set.
+	static void ApplyRoomDefaults(TSubclassOf<ARoom> room, FLabyrinthLayoutParams& params);
+
+	// Build with settings received from the server, using their seed. Settings that arrive while a build is in progress
+	// are kept, and the latest of them is built once the current build finishes.
+	void BuildFromSettings(const FLabyrinthBuildSettings& settings);
+
+	// Settings received during a build, waiting for it to finish.
+	bool HasPendingBuildSettings() const { return PendingBuildSettings.IsSet(); }
+
+	// Stats of the most recent build, complete once OnLabyrinthBuilt has fired.
+	UFUNCTION(BlueprintPure, Category = "Labyrinth Builder")
+	const FLabyrinthBuildStats& GetLastBuildStats() const { return LastBuildStats; }
+
+	// Append the stats of the most recent build to a file as one line of JSON.
+	UFUNCTION(BlueprintCallable, Category = "Labyrinth Builder")
+	bool AppendBuildStatsToFile(const FString& path) const;
+
+	// Heatmap of the most recent generated layout's distance field, one pixel per cell. Null for loaded layouts.
+	UFUNCTION(BlueprintCallable, Category = "Labyrinth Builder|Debug")
+	UTexture2D* CreateDistanceFieldTexture();
+
+	// Draw the distance field cells around the player. Also available as the labyrinth.DrawCells console command.
+	UFUNCTION(BlueprintCallable, Category = "Labyrinth Builder|Debug")
+	void DrawDebugCellsNearPlayer(int32 radiusCells = 16, float duration = 5.0f);
+
+	// Save the most recently built layout as a layout file that PrebuiltLayoutFile can point at.
+	UFUNCTION(BlueprintCallable, Category = "Labyrinth Builder")
+	bool SaveLayoutToFile(const FString& path) const;
+
+	// Checksum of the most recently built layout. Compare between machines to check they generated the same labyrinth.
+	UFUNCTION(BlueprintPure, Category = "Labyrinth Builder")
+	int32 GetLayoutHash() const { return static_cast<int32>(Layout.ComputeHash()); }
+
+	UFUNCTION(BlueprintPure, Category = "Labyrinth Builder")
+	bool IsBuildInProgress() const { return AsyncBuildCancelled.IsValid() || IsMaterializing; }
+
+	// Fraction of the labyrinth's pieces spawned so far. 1 when no spawning is pending.
+	UFUNCTION(BlueprintPure, Category = "Labyrinth Builder")
+	float GetMaterializationProgress() const { return IsMaterializing ? Materializer.GetProgress() : 1.0f; }
+
+	// Broadcast once a labyrinth has been spawned, whether it was built synchronously or asynchronously.
+	UPROPERTY(BlueprintAssignable, Category = "Labyrinth Builder")
+	FOnLabyrinthBuilt OnLabyrinthBuilt;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder")
 	bool BuildOnBeginPlay = true;
 
+	// Use BuildLabyrinthAsync when building on begin play.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder")
+	bool BuildAsynchronously = false;
+
+	// Append every build's stats as a line of JSON to Saved/Labyrinths/BuildStats.jsonl.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder")
+	bool WriteBuildStats = false;
+
+	// Spread spawning over several frames, nearest pieces to the player first.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder")
+	bool TimeSliceMaterialization = false;
+
+	// Time per frame spent spawning pieces when TimeSliceMaterialization is on.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder", meta = (ClampMin = "0.1", Units = "ms"))
+	float MaterializationBudgetMs = 4.0f;
+
+	// Layout file to spawn instead of generating, relative to the project's Content directory.
+	// Files under Content/Labyrinths are staged into cooked builds.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder", meta = (FilePathFilter = "Labyrinth layout (*.labyrinth)|*.labyrinth", RelativeToGameContentDir))
+	FFilePath PrebuiltLayoutFile;
+
+	// Check the layout file's checksums when loading it, which reads the whole file. Turn off for trusted files to spawn
+	// straight from the mapped sections. Section bounds and cell coordinates are checked either way.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder")
+	bool VerifyPrebuiltLayoutChecksums = true;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Random Seed")
 	bool UseExplicitRandomSeed = false;
 
@@ -42,6 +258,32 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder")
 	double CellUnit = 2.0;
 
+	// Only flood the distance field from cells added since the last update instead of from every zero distance cell.
+	// Produces the same distance field as a full recalculation.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder")
+	bool UseIncrementalDistanceField = true;
+
+	// Grow the distance field 64 cells at a time with bit masks instead of one cell at a time. Same distances, faster on large open labyrinths.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder")
+	bool UseWavefrontDistanceField = false;
+
+	// Labyrinths with at least this many cells flood the distance field across worker threads. Zero or less never does.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder", meta = (ClampMin = "0"))
+	int32 ParallelDistanceFieldMinCells = 2048 * 2048;
+
+	// How space is found for each new room.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder")
+	ELabyrinthPlacementStrategy PlacementStrategy = ELabyrinthPlacementStrategy::SearchRays;
+
+	// With search rays, how many are walked at once for each room. More rays mean fewer retries once the labyrinth is crowded.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder", meta = (ClampMin = "1"))
+	int32 NumCandidateRays = 1;
+
+	// With search rays, how many rooms are proposed at once and placed together before one distance field update.
+	// Larger batches place rooms faster on big layouts but lay hallways against a slightly older distance field.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Labyrinth Builder", meta = (ClampMin = "1"))
+	int32 RoomBatchSize = 1;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawn Assets")
 	TSubclassOf<ARoom> Room;
 
@@ -57,61 +299,81 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawn Assets")
 	TSubclassOf<AActor> HallWallBlueprint;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawn Assets")
+	ELabyrinthHallwayRenderMode HallwayRenderMode = ELabyrinthHallwayRenderMode::Actors;
+
+	// Merge runs of collinear hallway wall faces into one wall scaled along its length.
+	// Expects the hall wall to span one cell along its local Y axis.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawn Assets")
+	bool MergeHallwayWalls = false;
+
+	// Mesh used for hall floors when HallwayRenderMode is Instances. Should match HallFloorCeilingBlueprint.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawn Assets")
+	UStaticMesh* HallFloorCeilingMesh;
+
+	// Mesh used for hall walls when HallwayRenderMode is Instances. Should match HallWallBlueprint.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spawn Assets")
+	UStaticMesh* HallWallMesh;
+
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 private:
-	// Sentinel values for the distance field
-	static const int DISTANCE_FIELD_ROOM{ std::numeric_limits<int>::max() };
-	static const int DISTANCE_FIELD_UNCALCULATED{ std::numeric_limits<int>::max() - 1 };
-	static const int DISTANCE_FIELD_POTENTIAL_DOOR{ 0 };
-	static const int DISTANCE_FIELD_HALL{ std::numeric_limits<int>::min() };
+	// Check the settings and pick a seed. Returns false if there is nothing to build.
+	bool PrepareBuild(FLabyrinthLayoutParams& outParams);
 
-	AActor* SpawnUClass(TSubclassOf<AActor> actor, FIntVector2 cell, FRotator spawnRotation, AActor* parent);
-	AActor* SpawnUClass(TSubclassOf<AActor> actor, FVector spawnLocation, FRotator spawnRotation, AActor* parent);
+	// Layout parameters from this component's settings and the Room class defaults.
+	FLabyrinthLayoutParams MakeLayoutParams(int32 seed) const;
 
-	CellUnitConverter Converter = CellUnitConverter(CellUnit);
+	// Spawn PrebuiltLayoutFile if one is set. Returns false if no file is set, in which case the caller generates.
+	bool BuildFromPrebuiltLayout();
 
-	TArray<ARoom*> SpawnedRooms = TArray<ARoom*>();
+	// The generator's distance field belongs to the current layout and is not in use by a worker.
+	bool CanReadDistanceField() const;
 
-	TArray<FIntVector2> ZeroDistanceCoordinates = TArray<FIntVector2>();
+	// Owner is a replicated ALabyrinthBuilder without authority, so builds come from the server's settings.
+	bool IsReplicatedClient() const;
 
-	TArray<TArray<int>> DistanceField = TArray<TArray<int>>();
+	// Hand the settings for this build to a replicated owner so clients can build the same labyrinth.
+	void PublishBuildSettings(const FLabyrinthLayoutParams& params);
 
-	TArray<FIntVector2> TraversalDirections{ {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+	// Spawn the current layout, all at once or over several frames, and tell listeners.
+	void FinishBuild(bool loadedFromFile = false);
+	void FinishMaterialization();
 
-	FRandomStream RandomStream;
+	void OnAsyncLayoutGenerated(bool generated, TSharedRef<FLabyrinthLayout> layout);
 
-private:
-	void SpawnRooms();
-	void SpawnFirstRoom();
-	ARoom* SpawnRoom(FIntVector2 cell);
+	// Start the build for settings that arrived while the last one was in progress, if any did.
+	void BuildPendingSettings();
 
-	void AddRoomToDistanceField(FIntVector2 cell);
-	void AddRoomDoorsToDistanceField(FIntVector2 cell);
+	// Point the owner's instance components at the hallway meshes and clear previous instances.
+	// Falls back to actors if the owner is not an ALabyrinthBuilder.
+	FLabyrinthMaterializerSettings MakeMaterializerSettings();
 
-	FIntVector2 FindDoorCoordinate(FIntVector2 roomCell, FTransform door);
-	bool        IsInDistanceField(FIntVector2 cell);
-	bool        AreRoomExtentsWithinLabyrinth(FIntVector2 position, int sizeX, int sizeY);
+	// Shared with the worker thread while an asynchronous build runs.
+	TSharedRef<FLabyrinthLayoutGenerator> LayoutGenerator = MakeShared<FLabyrinthLayoutGenerator>();
 
-	void SetPotentialDoorCell(FIntVector2 cell);
-	void SetHallwayCell(FIntVector2 cell);
+	// Set while an asynchronous build is running. Setting the flag cancels it.
+	TSharedPtr<std::atomic<bool>> AsyncBuildCancelled;
 
-	FVector2D NextCoordinateAlongSearchPath(FVector2D currentposition, FVector2D searchDirection);
+	// Only the latest settings are kept, as every build replaces the labyrinth of the one before.
+	TOptional<FLabyrinthBuildSettings> PendingBuildSettings;
 
-	void ConnectToExistingRooms(FIntVector2 roomSpawnCoordinate, ARoom* room);
+	FLabyrinthLayout Layout;
 
-	void RecalculateDistanceField();
+	FLabyrinthMaterializer Materializer;
 
-	void SpawnDoorwayPrefabs();
+	// Pieces are still being spawned over several frames.
+	bool IsMaterializing = false;
 
-	void SpawnHallwayWalls();
-	void SpawnHallwayWall(FIntVector2 hallwayCell, FIntVector2 wallDirection);
+	FLabyrinthBuildStats LastBuildStats;
 
-	void DebugTempLogDistanceField();
+	FRandomStream RandomStream;
 };
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthCommandletParams.h"
+
+#include "LabyrinthBuilderComponent.h"
+#include "LabyrinthLayout.h"
+
+const TCHAR* const LabyrinthCommandletParams::DefaultRoomClassPath{ TEXT("/Game/Labyrinth/Blueprints/Room.Room_C") };
+
+bool LabyrinthCommandletParams::ParseGeneratorParams(const FString& commandLine, FLabyrinthLayoutParams& outParams, FString& outError)
+{
+    FParse::Value(*commandLine, TEXT("CellUnit="), outParams.CellUnit);
+    FParse::Value(*commandLine, TEXT("CandidateRays="), outParams.NumCandidateRays);
+    FParse::Value(*commandLine, TEXT("RoomBatch="), outParams.RoomBatchSize);
+    FParse::Value(*commandLine, TEXT("ParallelMinCells="), outParams.ParallelDistanceFieldMinCells);
+    outParams.bWavefrontDistanceField = FParse::Param(*commandLine, TEXT("Wavefront"));
+
+    if (outParams.NumCandidateRays < 1 || outParams.RoomBatchSize < 1)
+    {
+        outError = FString::Printf(TEXT("-CandidateRays=%i and -RoomBatch=%i must be at least 1"), outParams.NumCandidateRays, outParams.RoomBatchSize);
+        return false;
+    }
+
+    FString strategyName;
+    if (FParse::Value(*commandLine, TEXT("Strategy="), strategyName))
+    {
+        int64 strategy{ StaticEnum<ELabyrinthPlacementStrategy>()->GetValueByNameString(strategyName) };
+        if (strategy == INDEX_NONE)
+        {
+            outError = FString::Printf(TEXT("Unknown placement strategy %s"), *strategyName);
+            return false;
+        }
+
+        outParams.PlacementStrategy = static_cast<ELabyrinthPlacementStrategy>(strategy);
+    }
+
+    FString roomClassPath{ DefaultRoomClassPath };
+    FParse::Value(*commandLine, TEXT("Room="), roomClassPath);
+
+    TSubclassOf<ARoom> roomClass{ LoadClass<ARoom>(nullptr, *roomClassPath) };
+    if (!roomClass)
+    {
+        outError = FString::Printf(TEXT("Could not load room class %s"), *roomClassPath);
+        return false;
+    }
+
+    ULabyrinthBuilderComponent::ApplyRoomDefaults(roomClass, outParams);
+    if (outParams.RoomDoors.IsEmpty())
+    {
+        outError = FString::Printf(TEXT("Room class %s has no doors, so no hallways would be carved"), *roomClassPath);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FLabyrinthLayoutParams;
+
+/**
+ * Command line options shared by the labyrinth commandlets, so the same flags generate the same layouts in each.
+ */
+namespace LabyrinthCommandletParams
+{
+	// Rooms need a real size and doors for hallways to be carved, so the commandlets use the project's room unless told otherwise.
+	extern const TCHAR* const DefaultRoomClassPath;
+
+	// Read -CellUnit= -Strategy= -CandidateRays= -RoomBatch= -ParallelMinCells= -Wavefront and -Room= into params.
+	// The room class is applied last so its size is measured in the parsed cell unit, and it must have doors.
+	// Returns false with outError set if an option is invalid.
+	bool ParseGeneratorParams(const FString& commandLine, FLabyrinthLayoutParams& outParams, FString& outError);
+}
@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthDebug.h"
+
+#include "DrawDebugHelpers.h"
+#include "Engine/Texture2D.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+#include "LabyrinthBuilder.h"
+#include "LabyrinthDistanceField.h"
+
+namespace
+{
+#if !UE_BUILD_SHIPPING
+    TAutoConsoleVariable<bool> CVarLogDistanceField(
+        TEXT("labyrinth.LogDistanceField"),
+        false,
+        TEXT("Log each generated labyrinth's distance field as text. Slow for large labyrinths."));
+
+    FAutoConsoleCommandWithWorldAndArgs DrawCellsCommand(
+        TEXT("labyrinth.DrawCells"),
+        TEXT("Draw the distance field cells near the player for every labyrinth. Arguments: [radius in cells] [seconds]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& args, UWorld* world)
+        {
+            int32 radiusCells{ args.IsValidIndex(0) ? FCString::Atoi(*args[0]) : 16 };
+            float duration{ args.IsValidIndex(1) ? FCString::Atof(*args[1]) : 5.0f };
+
+            for (TActorIterator<ALabyrinthBuilder> builder(world); builder; ++builder)
+            {
+                builder->LabyrinthBuilderComponent->DrawDebugCellsNearPlayer(radiusCells, duration);
+            }
+        }));
+#endif
+
+    // Green for distance zero through to red for the furthest cell.
+    FColor DistanceColor(uint32 distance, uint32 maxDistance)
+    {
+        float fraction{ maxDistance > 0 ? static_cast<float>(distance) / maxDistance : 0.0f };
+        return FLinearColor::LerpUsingHSV(FLinearColor::Green, FLinearColor::Red, fraction).ToFColor(true);
+    }
+
+    FColor CellColor(const FLabyrinthDistanceField& distanceField, FIntVector2 cell, uint32 maxDistance)
+    {
+        if (distanceField.IsRoom(cell)) { return FColor::Blue; }
+        if (distanceField.IsHall(cell)) { return FColor::White; }
+        if (distanceField.IsPotentialDoor(cell)) { return FColor::Yellow; }
+
+        uint32 distance{ distanceField.GetDistance(cell) };
+        return distance == FLabyrinthDistanceField::Unreached ? FColor::Black : DistanceColor(distance, maxDistance);
+    }
+}
+
+bool LabyrinthDebug::IsDistanceFieldLogEnabled()
+{
+#if !UE_BUILD_SHIPPING
+    return CVarLogDistanceField.GetValueOnGameThread();
+#else
+    return false;
+#endif
+}
+
+void LabyrinthDebug::LogDistanceField(const FLabyrinthDistanceField& distanceField)
+{
+#if !UE_BUILD_SHIPPING
+    const FIntVector2 dimensions{ distanceField.GetDimensions() };
+
+    UE_LOG(LogTemp, Log, TEXT("Distance field (%i x %i):"), dimensions.X, dimensions.Y);
+
+    // One line per row keeps each log call small however large the labyrinth is.
+    FString row;
+    row.Reserve((dimensions.X * 4) + 8);
+
+    for (int32 y = 0; y < dimensions.Y; y++)
+    {
+        row.Reset();
+        row.Appendf(TEXT("%04d "), y);
+
+        for (int32 x = 0; x < dimensions.X; x++)
+        {
+            FIntVector2 cell{ x, y };
+            uint32 distance{ distanceField.GetDistance(cell) };
+
+            if (distanceField.IsRoom(cell))
+            {
+                row += TEXT(" RR ");
+            }
+            else if (distanceField.IsHall(cell))
+            {
+                row += TEXT(" HH ");
+            }
+            else if (distance == FLabyrinthDistanceField::Unreached)
+            {
+                row += TEXT(" .. ");
+            }
+            else
+            {
+                row.Appendf(TEXT("%3u "), FMath::Min(distance, 999u));
+            }
+        }
+
+        UE_LOG(LogTemp, Log, TEXT("%s"), *row);
+    }
+#endif
+}
+
+UTexture2D* LabyrinthDebug::CreateDistanceFieldTexture(const FLabyrinthDistanceField& distanceField, UObject* outer)
+{
+    const FIntVector2 dimensions{ distanceField.GetDimensions() };
+    if (dimensions.X <= 0 || dimensions.Y <= 0)
+    {
+        return nullptr;
+    }
+
+    uint32 maxDistance{ 0 };
+    for (int32 y = 0; y < dimensions.Y; y++)
+    {
+        for (int32 x = 0; x < dimensions.X; x++)
+        {
+            uint32 distance{ distanceField.GetDistance(FIntVector2{ x, y }) };
+            if (distance != FLabyrinthDistanceField::Unreached)
+            {
+                maxDistance = FMath::Max(maxDistance, distance);
+            }
+        }
+    }
+
+    UTexture2D* texture = UTexture2D::CreateTransient(dimensions.X, dimensions.Y, PF_B8G8R8A8, TEXT("LabyrinthDistanceField"));
+    if (!texture)
+    {
+        return nullptr;
+    }
+
+    if (outer)
+    {
+        texture->Rename(nullptr, outer, REN_DontCreateRedirectors | REN_NonTransactional);
+    }
+
+    texture->Filter = TF_Nearest;
+    texture->SRGB = true;
+
+    FTexture2DMipMap& mip = texture->GetPlatformData()->Mips[0];
+    FColor* pixels = static_cast<FColor*>(mip.BulkData.Lock(LOCK_READ_WRITE));
+
+    for (int32 y = 0; y < dimensions.Y; y++)
+    {
+        for (int32 x = 0; x < dimensions.X; x++)
+        {
+            pixels[(y * dimensions.X) + x] = CellColor(distanceField, FIntVector2{ x, y }, maxDistance);
+        }
+    }
+
+    mip.BulkData.Unlock();
+    texture->UpdateResource();
+
+    return texture;
+}
+
+void LabyrinthDebug::DrawCellsNear(const UWorld* world, const FLabyrinthDistanceField& distanceField, const FTransform& labyrinthTransform,
+    double cellUnit, FVector location, int32 radiusCells, float duration)
+{
+#if ENABLE_DRAW_DEBUG
+    const FIntVector2 dimensions{ distanceField.GetDimensions() };
+    if (!world || dimensions.X <= 0 || dimensions.Y <= 0 || cellUnit <= 0.0)
+    {
+        return;
+    }
+
+    FVector localLocation{ labyrinthTransform.InverseTransformPosition(location) };
+    FIntVector2 center{ FMath::FloorToInt32(localLocation.X / cellUnit), FMath::FloorToInt32(localLocation.Y / cellUnit) };
+
+    FIntVector2 minCell{ FMath::Max(center.X - radiusCells, 0), FMath::Max(center.Y - radiusCells, 0) };
+    FIntVector2 maxCell{ FMath::Min(center.X + radiusCells, dimensions.X - 1), FMath::Min(center.Y + radiusCells, dimensions.Y - 1) };
+
+    // Colors are scaled to the distances in view so nearby differences stay visible.
+    uint32 maxDistance{ 0 };
+    for (int32 y = minCell.Y; y <= maxCell.Y; y++)
+    {
+        for (int32 x = minCell.X; x <= maxCell.X; x++)
+        {
+            uint32 distance{ distanceField.GetDistance(FIntVector2{ x, y }) };
+            if (distance != FLabyrinthDistanceField::Unreached)
+            {
+                maxDistance = FMath::Max(maxDistance, distance);
+            }
+        }
+    }
+
+    FVector extent{ cellUnit * 0.45, cellUnit * 0.45, cellUnit * 0.05 };
+    FQuat rotation{ labyrinthTransform.GetRotation() };
+
+    for (int32 y = minCell.Y; y <= maxCell.Y; y++)
+    {
+        for (int32 x = minCell.X; x <= maxCell.X; x++)
+        {
+            FIntVector2 cell{ x, y };
+            if (distanceField.GetDistance(cell) == FLabyrinthDistanceField::Unreached && !distanceField.IsRoom(cell))
+            {
+                continue;
+            }
+
+            FVector cellCenter{ labyrinthTransform.TransformPosition(FVector{ (x + 0.5) * cellUnit, (y + 0.5) * cellUnit, 0 }) };
+            DrawDebugSolidBox(world, cellCenter, extent, rotation, CellColor(distanceField, cell, maxDistance).WithAlpha(96), false, duration);
+        }
+    }
+#endif
+}
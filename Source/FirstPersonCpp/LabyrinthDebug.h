@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FLabyrinthDistanceField;
+class UTexture2D;
+
+/**
+ * Ways to look at a distance field while working on the generator.
+ * Logging and debug drawing are compiled out of Shipping builds.
+ */
+namespace LabyrinthDebug
+{
+	// Set by the labyrinth.LogDistanceField console variable. Always false in Shipping.
+	FIRSTPERSONCPP_API bool IsDistanceFieldLogEnabled();
+
+	// Log the distance field as text, one line per row.
+	FIRSTPERSONCPP_API void LogDistanceField(const FLabyrinthDistanceField& distanceField);
+
+	// One pixel per cell: rooms blue, halls white, potential doors yellow, unreached black,
+	// anything else green to red by distance. Row y of the labyrinth is row y of the texture.
+	FIRSTPERSONCPP_API UTexture2D* CreateDistanceFieldTexture(const FLabyrinthDistanceField& distanceField, UObject* outer);
+
+	// Draw a box over every reached cell within radiusCells of location.
+	// labyrinthTransform is the labyrinth owner's transform, cellUnit the size of one cell in its space.
+	FIRSTPERSONCPP_API void DrawCellsNear(const UWorld* world, const FLabyrinthDistanceField& distanceField, const FTransform& labyrinthTransform,
+		double cellUnit, FVector location, int32 radiusCells, float duration);
+}
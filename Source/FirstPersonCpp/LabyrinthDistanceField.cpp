@@ -0,0 +1,280 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthDistanceField.h"
+
+void FLabyrinthDistanceField::Init(FIntVector2 dimensions)
+{
+    Dimensions = FIntVector2{ FMath::Max(dimensions.X, 0), FMath::Max(dimensions.Y, 0) };
+
+    RoomPlane.Init(Dimensions);
+    HallPlane.Init(Dimensions);
+    DoorPlane.Init(Dimensions);
+    BlockedPlane.Init(Dimensions);
+
+    // Hallway distances stay far below 0xFFFF on almost any grid, so start compact and widen only if a flood runs out.
+    bCompactDistances = true;
+    CompactDistances.Init(Dimensions, MAX_uint16);
+    WideDistances.Init(FIntVector2{ 0, 0 }, Unreached);
+}
+
+void FLabyrinthDistanceField::WidenDistances(TArray<FIntVector2>& outSaturatedCells)
+{
+    constexpr uint16 LastCompactDistance{ MAX_uint16 - 1 };
+
+    WideDistances.Init(Dimensions, Unreached);
+    outSaturatedCells.Reset();
+
+    for (int32 index = 0; index < CompactDistances.Num(); index++)
+    {
+        uint16 distance{ CompactDistances[index] };
+        if (distance == MAX_uint16)
+        {
+            continue;
+        }
+
+        WideDistances[index] = distance;
+        if (distance == LastCompactDistance)
+        {
+            outSaturatedCells.Add(CompactDistances.ToCell(index));
+        }
+    }
+
+    CompactDistances.Init(FIntVector2{ 0, 0 }, MAX_uint16);
+    bCompactDistances = false;
+}
+
+void FLabyrinthDistanceField::SetRoom(FIntVector2 cell)
+{
+    RoomPlane.Set(cell);
+    BlockedPlane.Set(cell);
+    SetDistance(cell, Unreached);
+}
+
+void FLabyrinthDistanceField::SetPotentialDoor(FIntVector2 cell)
+{
+    DoorPlane.Set(cell);
+    BlockedPlane.Set(cell);
+    SetDistance(cell, 0);
+}
+
+void FLabyrinthDistanceField::SetHall(FIntVector2 cell)
+{
+    // hall overrides potential door
+    DoorPlane.Clear(cell);
+    HallPlane.Set(cell);
+    BlockedPlane.Set(cell);
+    SetDistance(cell, 0);
+}
+
+uint32 FLabyrinthDistanceField::GetDistance(FIntVector2 cell) const
+{
+    if (bCompactDistances)
+    {
+        uint16 distance = CompactDistances[cell];
+        return distance == MAX_uint16 ? Unreached : distance;
+    }
+
+    return WideDistances[cell];
+}
+
+void FLabyrinthDistanceField::ResetDistances()
+{
+    if (bCompactDistances)
+    {
+        CompactDistances.Fill(MAX_uint16);
+    }
+    else
+    {
+        WideDistances.Fill(Unreached);
+    }
+
+    for (int32 y = 0; y < Dimensions.Y; y++)
+    {
+        TConstArrayView<uint64> hallWords{ HallPlane.GetRowWords(y) };
+        TConstArrayView<uint64> doorWords{ DoorPlane.GetRowWords(y) };
+
+        for (int32 wordIndex = 0; wordIndex < hallWords.Num(); wordIndex++)
+        {
+            uint64 zeroCells{ hallWords[wordIndex] | doorWords[wordIndex] };
+            while (zeroCells != 0)
+            {
+                int32 bit{ static_cast<int32>(FMath::CountTrailingZeros64(zeroCells)) };
+                zeroCells &= zeroCells - 1;
+
+                SetDistance(FIntVector2{ (wordIndex * FLabyrinthBitPlane::BitsPerWord) + bit, y }, 0);
+            }
+        }
+    }
+}
+
+void FLabyrinthDistanceField::SetDistance(FIntVector2 cell, uint32 distance)
+{
+    if (bCompactDistances)
+    {
+        CompactDistances[cell] = distance == Unreached ? MAX_uint16 : static_cast<uint16>(distance);
+    }
+    else
+    {
+        WideDistances[cell] = distance;
+    }
+}
+
+int32 FLabyrinthDistanceField::GetPathCost(FIntVector2 cell) const
+{
+    if (RoomPlane.Get(cell)) { return PathCostRoom; }
+    if (HallPlane.Get(cell)) { return PathCostHall; }
+
+    uint32 distance = GetDistance(cell);
+    return distance == Unreached ? PathCostUnreached : static_cast<int32>(distance);
+}
+
+template<typename FloodFunction>
+int32 FLabyrinthDistanceField::FloodCompactThenWide(TConstArrayView<FIntVector2> seeds, FloodFunction flood)
+{
+    bool bSaturated{ false };
+    if (!bCompactDistances)
+    {
+        return flood(WideDistances, seeds, bSaturated);
+    }
+
+    int32 numVisited{ flood(CompactDistances, seeds, bSaturated) };
+    if (!bSaturated)
+    {
+        return numVisited;
+    }
+
+    // The flood stopped at the last distance uint16 holds. Carry on from there in uint32.
+    TArray<FIntVector2> saturatedCells;
+    WidenDistances(saturatedCells);
+
+    return numVisited + flood(WideDistances, saturatedCells, bSaturated);
+}
+
+int32 FLabyrinthDistanceField::Flood(TConstArrayView<FIntVector2> seeds, TLabyrinthRingBuffer<int32>& frontier)
+{
+    return FloodCompactThenWide(seeds, [this, &frontier](auto& distances, TConstArrayView<FIntVector2> floodSeeds, bool& bOutSaturated)
+    {
+        return FloodDistances(distances, floodSeeds, frontier, bOutSaturated);
+    });
+}
+
+int32 FLabyrinthDistanceField::Flood(TConstArrayView<FIntVector2> seeds, FLabyrinthWavefront& wavefront)
+{
+    return FloodCompactThenWide(seeds, [this, &wavefront](auto& distances, TConstArrayView<FIntVector2> floodSeeds, bool& bOutSaturated)
+    {
+        return wavefront.Flood(distances, RoomPlane, floodSeeds, bOutSaturated);
+    });
+}
+
+int32 FLabyrinthDistanceField::Flood(TConstArrayView<FIntVector2> seeds, FLabyrinthParallelFlood& parallelFlood)
+{
+    return FloodCompactThenWide(seeds, [this, &parallelFlood](auto& distances, TConstArrayView<FIntVector2> floodSeeds, bool& bOutSaturated)
+    {
+        return parallelFlood.Flood(distances, RoomPlane, floodSeeds, bOutSaturated);
+    });
+}
+
+template<typename DistanceType>
+int32 FLabyrinthDistanceField::FloodDistances(TLabyrinthGrid<DistanceType>& distances, TConstArrayView<FIntVector2> seeds, TLabyrinthRingBuffer<int32>& frontier, bool& bOutSaturated)
+{
+    static const FIntVector2 Neighbors[]{ {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+
+    frontier.Reset();
+    for (FIntVector2 seed : seeds)
+    {
+        frontier.Push(distances.ToIndex(seed));
+    }
+
+    bOutSaturated = false;
+
+    int32 numVisited{ 0 };
+    int32 currentIndex{};
+    while (frontier.Pop(currentIndex))
+    {
+        // Seeds share a distance, so cells come off in distance order and everything left is at least this far.
+        if (distances[currentIndex] == TNumericLimits<DistanceType>::Max() - 1)
+        {
+            bOutSaturated = true;
+            break;
+        }
+
+        numVisited++;
+
+        FIntVector2 currentCoordinate{ distances.ToCell(currentIndex) };
+        DistanceType nextDistance = distances[currentIndex] + 1;
+
+        // Check each direction. If a neighbor cell needs a value, update and queue it. Otherwise move to the next cell.
+        for (FIntVector2 direction : Neighbors)
+        {
+            FIntVector2 cellToCheck = currentCoordinate + direction;
+
+            if (!distances.IsInBounds(cellToCheck) || RoomPlane.Get(cellToCheck))
+            {
+                continue;
+            }
+
+            int32 neighborIndex = distances.ToIndex(cellToCheck);
+            DistanceType& neighborDistance = distances[neighborIndex];
+
+            if (neighborDistance > nextDistance)
+            {
+                neighborDistance = nextDistance;
+                frontier.Push(neighborIndex);
+            }
+        }
+    }
+
+    return numVisited;
+}
+
+uint64 FLabyrinthDistanceField::GetOpenWord(int32 y, int32 wordIndex) const
+{
+    if (y < 0 || y >= Dimensions.Y)
+    {
+        return ~uint64(0);
+    }
+
+    return ~(HallPlane.GetRowWords(y)[wordIndex] | RoomPlane.GetRowWords(y)[wordIndex]);
+}
+
+uint64 FLabyrinthDistanceField::GetHallWallWord(int32 y, int32 wordIndex, FIntVector2 direction) const
+{
+    uint64 hallWord = HallPlane.GetRowWords(y)[wordIndex];
+    if (hallWord == 0)
+    {
+        return 0;
+    }
+
+    uint64 neighborOpen{ 0 };
+
+    if (direction.Y != 0)
+    {
+        neighborOpen = GetOpenWord(y + direction.Y, wordIndex);
+    }
+    else if (direction.X < 0)
+    {
+        // bit x holds the state of cell x - 1, carried in from the previous word
+        uint64 carry = wordIndex > 0 ? GetOpenWord(y, wordIndex - 1) >> 63 : 1;
+        neighborOpen = (GetOpenWord(y, wordIndex) << 1) | carry;
+    }
+    else
+    {
+        // bit x holds the state of cell x + 1, carried in from the next word.
+        // Bits past the row end are never hall or room, so the last cell in a row always sees an open neighbor.
+        uint64 carry = wordIndex + 1 < GetWordsPerRow() ? GetOpenWord(y, wordIndex + 1) & 1 : 1;
+        neighborOpen = (GetOpenWord(y, wordIndex) >> 1) | (carry << 63);
+    }
+
+    return hallWord & neighborOpen;
+}
+
+SIZE_T FLabyrinthDistanceField::GetAllocatedSize() const
+{
+    return
+        RoomPlane.GetAllocatedSize() +
+        HallPlane.GetAllocatedSize() +
+        DoorPlane.GetAllocatedSize() +
+        BlockedPlane.GetAllocatedSize() +
+        CompactDistances.GetAllocatedSize() +
+        WideDistances.GetAllocatedSize();
+}
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthBitPlane.h"
+#include "LabyrinthGrid.h"
+#include "LabyrinthParallelFlood.h"
+#include "LabyrinthRingBuffer.h"
+#include "LabyrinthWavefront.h"
+
+/**
+ * Labyrinth cell state and hallway distances.
+ * Cell state lives in packed bit planes (room, hall, potential door, blocked) and distances live in their own grid.
+ * Distances start out as uint16 and move to uint32 the first time a flood would need 0xFFFF, which only hallway
+ * networks tens of thousands of cells long ever do.
+ */
+class FIRSTPERSONCPP_API FLabyrinthDistanceField
+{
+public:
+	// Distance of a cell no zero distance cell has reached yet.
+	static constexpr uint32 Unreached{ MAX_uint32 };
+
+	// Path costs order cells the same way the old single int encoding did: hall < door/distance < unreached < room.
+	static constexpr int32 PathCostHall{ MIN_int32 };
+	static constexpr int32 PathCostUnreached{ MAX_int32 - 1 };
+	static constexpr int32 PathCostRoom{ MAX_int32 };
+
+	void Init(FIntVector2 dimensions);
+
+	FIntVector2 GetDimensions() const { return Dimensions; }
+	int32 Num() const { return Dimensions.X * Dimensions.Y; }
+
+	bool IsInBounds(FIntVector2 cell) const
+	{
+		return
+			(cell.X >= 0) &&
+			(cell.Y >= 0) &&
+			(cell.X < Dimensions.X) &&
+			(cell.Y < Dimensions.Y);
+	}
+
+	bool IsRoom(FIntVector2 cell) const { return RoomPlane.Get(cell); }
+	bool IsHall(FIntVector2 cell) const { return HallPlane.Get(cell); }
+	bool IsPotentialDoor(FIntVector2 cell) const { return DoorPlane.Get(cell); }
+
+	// Room, hall or potential door. New rooms cannot cover blocked cells.
+	bool IsBlocked(FIntVector2 cell) const { return BlockedPlane.Get(cell); }
+
+	// Room, hall and potential door cells, which new rooms may not overlap
+	const FLabyrinthBitPlane& GetBlockedPlane() const { return BlockedPlane; }
+
+	void SetRoom(FIntVector2 cell);
+	void SetPotentialDoor(FIntVector2 cell);
+	void SetHall(FIntVector2 cell);
+
+	uint32 GetDistance(FIntVector2 cell) const;
+
+	// Forget every flooded distance, leaving hall and potential door cells at zero, so the next flood starts over.
+	// Does not allocate.
+	void ResetDistances();
+
+	// Ordering key used to walk hallways downhill towards existing halls and doors.
+	int32 GetPathCost(FIntVector2 cell) const;
+
+	// Flood distances outwards from the given zero distance cells, using frontier as the BFS queue.
+	// Only lowers distances, so cells already closer to another zero distance cell are left alone.
+	// Returns the number of cells taken off the frontier.
+	int32 Flood(TConstArrayView<FIntVector2> seeds, TLabyrinthRingBuffer<int32>& frontier);
+
+	// Same as Flood, but grows the frontier 64 cells at a time. Leaves exactly the same distances.
+	int32 Flood(TConstArrayView<FIntVector2> seeds, FLabyrinthWavefront& wavefront);
+
+	// Same as Flood, but each level of the frontier is expanded across worker threads. Leaves exactly the same distances.
+	int32 Flood(TConstArrayView<FIntVector2> seeds, FLabyrinthParallelFlood& parallelFlood);
+
+	// Mask of the hall cells in one 64 cell word of row y whose neighbor in the given direction needs a wall,
+	// i.e. is neither hall nor room. Cells outside the grid count as needing a wall.
+	uint64 GetHallWallWord(int32 y, int32 wordIndex, FIntVector2 direction) const;
+
+	int32 GetWordsPerRow() const { return HallPlane.GetWordsPerRow(); }
+
+	// False once a flood has run past the distances uint16 can hold.
+	bool UsesCompactDistances() const { return bCompactDistances; }
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	template<typename DistanceType>
+	int32 FloodDistances(TLabyrinthGrid<DistanceType>& distances, TConstArrayView<FIntVector2> seeds, TLabyrinthRingBuffer<int32>& frontier, bool& bOutSaturated);
+
+	// Run flood on the compact distances, and if it saturates, widen them and finish the flood on the wide distances.
+	template<typename FloodFunction>
+	int32 FloodCompactThenWide(TConstArrayView<FIntVector2> seeds, FloodFunction flood);
+
+	// Copy the compact distances into the wide grid. outSaturatedCells gets the cells at the last compact distance.
+	void WidenDistances(TArray<FIntVector2>& outSaturatedCells);
+
+	void SetDistance(FIntVector2 cell, uint32 distance);
+
+	// Cells that are neither hall nor room for one word of a row. Rows outside the grid are fully open.
+	uint64 GetOpenWord(int32 y, int32 wordIndex) const;
+
+	FIntVector2 Dimensions{ 0, 0 };
+
+	FLabyrinthBitPlane RoomPlane;
+	FLabyrinthBitPlane HallPlane;
+	FLabyrinthBitPlane DoorPlane;
+	FLabyrinthBitPlane BlockedPlane;
+
+	bool bCompactDistances{ true };
+	TLabyrinthGrid<uint16> CompactDistances;
+	TLabyrinthGrid<uint32> WideDistances;
+};
@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthBitPlane.h"
+#include "LabyrinthGrid.h"
+
+/**
+ * For every cell, the side of the largest empty square with its minimum corner there, capped at the room's shorter side.
+ * A room fits at an anchor when the squares tiling its longer side all reach the cap, so the set of valid anchors is kept
+ * alongside and a room can be placed by picking one of them at random. When the set is empty the labyrinth is full.
+ *
+ * Because sides are capped, a changed cell only affects the cells up to one room away above and to the left of it,
+ * so Update recomputes just that region around the cells marked dirty.
+ */
+class FLabyrinthEmptySquareMap
+{
+public:
+	void Init(FIntVector2 dimensions, FIntVector2 roomSize)
+	{
+		Dimensions = FIntVector2{ FMath::Max(dimensions.X, 0), FMath::Max(dimensions.Y, 0) };
+		RoomSize = roomSize;
+		SquareSide = FMath::Clamp(FMath::Min(roomSize.X, roomSize.Y), 1, static_cast<int32>(MAX_uint16));
+
+		Sides.Init(Dimensions, 0);
+		ValidAnchors.Init(Dimensions);
+		ValidAnchorsPerRow.Init(0, Dimensions.Y);
+		NumValidAnchors = 0;
+
+		// Nothing has been computed yet, so the first Update covers everything.
+		DirtyMin = FIntVector2{ 0, 0 };
+		DirtyMax = FIntVector2{ Dimensions.X - 1, Dimensions.Y - 1 };
+	}
+
+	// Note that a rectangle of the source plane changed. Anchors are stale until the next Update.
+	void MarkDirty(FIntVector2 min, FIntVector2 size = FIntVector2{ 1, 1 })
+	{
+		DirtyMin.X = FMath::Min(DirtyMin.X, min.X);
+		DirtyMin.Y = FMath::Min(DirtyMin.Y, min.Y);
+		DirtyMax.X = FMath::Max(DirtyMax.X, min.X + size.X - 1);
+		DirtyMax.Y = FMath::Max(DirtyMax.Y, min.Y + size.Y - 1);
+	}
+
+	bool IsDirty() const { return DirtyMin.X <= DirtyMax.X && DirtyMin.Y <= DirtyMax.Y; }
+
+	// Bring the map up to date with blocked, which must have the dimensions the map was initialized with.
+	void Update(const FLabyrinthBitPlane& blocked)
+	{
+		if (!IsDirty())
+		{
+			return;
+		}
+
+		// Sides that can have changed
+		FIntVector2 sideMin{ FMath::Max(DirtyMin.X - SquareSide + 1, 0), FMath::Max(DirtyMin.Y - SquareSide + 1, 0) };
+		FIntVector2 sideMax{ FMath::Min(DirtyMax.X, Dimensions.X - 1), FMath::Min(DirtyMax.Y, Dimensions.Y - 1) };
+
+		// Each side depends on its right, lower and diagonal neighbours, so walk backwards from the bottom right.
+		for (int32 y = sideMax.Y; y >= sideMin.Y; y--)
+		{
+			for (int32 x = sideMax.X; x >= sideMin.X; x--)
+			{
+				FIntVector2 cell{ x, y };
+				if (blocked.Get(cell))
+				{
+					Sides[cell] = 0;
+					continue;
+				}
+
+				int32 smallest{ FMath::Min3(GetSide(FIntVector2{ x + 1, y }), GetSide(FIntVector2{ x, y + 1 }), GetSide(FIntVector2{ x + 1, y + 1 })) };
+				Sides[cell] = static_cast<uint16>(FMath::Min(smallest + 1, SquareSide));
+			}
+		}
+
+		// Anchors whose tiling squares include a changed side
+		FIntVector2 anchorMin{
+			FMath::Max(sideMin.X - (RoomSize.X - SquareSide), 0),
+			FMath::Max(sideMin.Y - (RoomSize.Y - SquareSide), 0) };
+
+		for (int32 y = anchorMin.Y; y <= sideMax.Y; y++)
+		{
+			for (int32 x = anchorMin.X; x <= sideMax.X; x++)
+			{
+				FIntVector2 cell{ x, y };
+				bool valid{ DoesRoomFit(cell) };
+
+				if (valid == ValidAnchors.Get(cell))
+				{
+					continue;
+				}
+
+				if (valid)
+				{
+					ValidAnchors.Set(cell);
+				}
+				else
+				{
+					ValidAnchors.Clear(cell);
+				}
+
+				int32 change{ valid ? 1 : -1 };
+				ValidAnchorsPerRow[y] += change;
+				NumValidAnchors += change;
+			}
+		}
+
+		DirtyMin = FIntVector2{ MAX_int32, MAX_int32 };
+		DirtyMax = FIntVector2{ MIN_int32, MIN_int32 };
+	}
+
+	// Constant time, so running out of space is noticed without searching.
+	bool HasValidAnchor() const { checkSlow(!IsDirty()); return NumValidAnchors > 0; }
+
+	int32 GetNumValidAnchors() const { checkSlow(!IsDirty()); return NumValidAnchors; }
+
+	bool IsValidAnchor(FIntVector2 cell) const { checkSlow(!IsDirty()); return ValidAnchors.Get(cell); }
+
+	// The valid anchor at index in row-major order. Index must be less than GetNumValidAnchors.
+	FIntVector2 GetValidAnchor(int32 index) const
+	{
+		checkSlow(!IsDirty());
+		checkSlow(index >= 0 && index < NumValidAnchors);
+
+		int32 y{ 0 };
+		while (index >= ValidAnchorsPerRow[y])
+		{
+			index -= ValidAnchorsPerRow[y];
+			y++;
+		}
+
+		TConstArrayView<uint64> words{ ValidAnchors.GetRowWords(y) };
+		for (int32 word = 0; word < words.Num(); word++)
+		{
+			uint64 bits{ words[word] };
+			int32 count{ static_cast<int32>(FMath::CountBits(bits)) };
+
+			if (index >= count)
+			{
+				index -= count;
+				continue;
+			}
+
+			// Drop the lower set bits until the one we want is lowest.
+			for (; index > 0; index--)
+			{
+				bits &= bits - 1;
+			}
+
+			return FIntVector2{ (word * FLabyrinthBitPlane::BitsPerWord) + static_cast<int32>(FMath::CountTrailingZeros64(bits)), y };
+		}
+
+		checkNoEntry();
+		return FIntVector2{ 0, 0 };
+	}
+
+	SIZE_T GetAllocatedSize() const { return Sides.GetAllocatedSize() + ValidAnchors.GetAllocatedSize() + ValidAnchorsPerRow.GetAllocatedSize(); }
+
+private:
+	int32 GetSide(FIntVector2 cell) const { return Sides.IsInBounds(cell) ? Sides[cell] : 0; }
+
+	// The room is covered by squares of the shorter side stepped along the longer one, the last flush with the far edge.
+	// Like the search rays, a room keeps clear of the last row and column of the labyrinth.
+	bool DoesRoomFit(FIntVector2 cell) const
+	{
+		if (cell.X + RoomSize.X >= Dimensions.X || cell.Y + RoomSize.Y >= Dimensions.Y)
+		{
+			return false;
+		}
+
+		FIntVector2 lastOffset{ RoomSize.X - SquareSide, RoomSize.Y - SquareSide };
+		FIntVector2 offset{ 0, 0 };
+
+		while (true)
+		{
+			if (Sides[cell + offset] < SquareSide)
+			{
+				return false;
+			}
+
+			if (offset == lastOffset)
+			{
+				return true;
+			}
+
+			offset.X = FMath::Min(offset.X + SquareSide, lastOffset.X);
+			offset.Y = FMath::Min(offset.Y + SquareSide, lastOffset.Y);
+		}
+	}
+
+	// Largest empty square side at each cell, up to SquareSide
+	TLabyrinthGrid<uint16> Sides;
+
+	FLabyrinthBitPlane ValidAnchors;
+	TArray<int32> ValidAnchorsPerRow;
+	int32 NumValidAnchors = 0;
+
+	FIntVector2 Dimensions{ 0, 0 };
+	FIntVector2 RoomSize{ 1, 1 };
+	int32 SquareSide = 1;
+
+	// Bounds of the cells changed since the last Update
+	FIntVector2 DirtyMin{ MAX_int32, MAX_int32 };
+	FIntVector2 DirtyMax{ MIN_int32, MIN_int32 };
+};
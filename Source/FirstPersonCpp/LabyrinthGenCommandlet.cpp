@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthGenCommandlet.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformFileManager.h"
+#include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "LabyrinthCommandletParams.h"
+#include "LabyrinthLayoutFile.h"
+#include "LabyrinthLayoutGenerator.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLabyrinthGen, Log, All);
+
+namespace
+{
+    // Parse "<x>x<y>" such as "40x40".
+    bool ParseDimensions(const FString& text, FIntVector2& outDimensions)
+    {
+        FString x, y;
+        if (!text.Split(TEXT("x"), &x, &y, ESearchCase::IgnoreCase) || !x.IsNumeric() || !y.IsNumeric())
+        {
+            return false;
+        }
+
+        outDimensions = FIntVector2{ FCString::Atoi(*x), FCString::Atoi(*y) };
+        return outDimensions.X > 0 && outDimensions.Y > 0;
+    }
+}
+
+ULabyrinthGenCommandlet::ULabyrinthGenCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 ULabyrinthGenCommandlet::Main(const FString& Params)
+{
+    int32 firstSeed{ 0 };
+    int32 numSeeds{ 100 };
+    FLabyrinthLayoutParams baseParams{};
+    FString outputDirectory{ FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Labyrinths")) };
+
+    FParse::Value(*Params, TEXT("FirstSeed="), firstSeed);
+    FParse::Value(*Params, TEXT("NumSeeds="), numSeeds);
+    FParse::Value(*Params, TEXT("Rooms="), baseParams.NumberOfRooms);
+    FParse::Value(*Params, TEXT("Output="), outputDirectory);
+    baseParams.bMergeHallwayWalls = FParse::Param(*Params, TEXT("MergeWalls"));
+    bool statsOnly{ FParse::Param(*Params, TEXT("StatsOnly")) };
+
+    FString dimensionsText;
+    if (FParse::Value(*Params, TEXT("Dimensions="), dimensionsText) && !ParseDimensions(dimensionsText, baseParams.Dimensions))
+    {
+        UE_LOG(LogLabyrinthGen, Error, TEXT("Could not read -Dimensions=%s, expected <x>x<y>"), *dimensionsText);
+        return 1;
+    }
+
+    FString paramsError;
+    if (!LabyrinthCommandletParams::ParseGeneratorParams(Params, baseParams, paramsError))
+    {
+        UE_LOG(LogLabyrinthGen, Error, TEXT("%s"), *paramsError);
+        return 1;
+    }
+
+    if (numSeeds < 1 || baseParams.NumberOfRooms < 1)
+    {
+        UE_LOG(LogLabyrinthGen, Error, TEXT("Nothing to generate for %i seeds of %i rooms"), numSeeds, baseParams.NumberOfRooms);
+        return 1;
+    }
+
+    if (!FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*outputDirectory))
+    {
+        UE_LOG(LogLabyrinthGen, Error, TEXT("Could not create output directory %s"), *outputDirectory);
+        return 1;
+    }
+
+    UE_LOG(LogLabyrinthGen, Display, TEXT("Generating seeds %i to %i, %i x %i cells, %i rooms, %s placement, into %s"),
+        firstSeed, firstSeed + numSeeds - 1, baseParams.Dimensions.X, baseParams.Dimensions.Y, baseParams.NumberOfRooms,
+        *StaticEnum<ELabyrinthPlacementStrategy>()->GetNameStringByValue(static_cast<int64>(baseParams.PlacementStrategy)), *outputDirectory);
+
+    // Written in seed order once every seed is done.
+    TArray<FLabyrinthGenSeedStats> seedStats;
+    seedStats.SetNum(numSeeds);
+
+    std::atomic<int32> numFailed{ 0 };
+    double startTime{ FPlatformTime::Seconds() };
+
+    // Every worker keeps its own generator so the scratch buffers are reused across the seeds it runs.
+    TArray<FLabyrinthLayoutGenerator> generators;
+    ParallelForWithTaskContext(generators, numSeeds, [&](FLabyrinthLayoutGenerator& generator, int32 index)
+    {
+        FLabyrinthLayoutParams params{ baseParams };
+        params.Seed = firstSeed + index;
+
+        FLabyrinthLayout layout;
+        double seedStartTime{ FPlatformTime::Seconds() };
+        bool generated{ generator.Generate(params, layout) };
+        double generateMs{ (FPlatformTime::Seconds() - seedStartTime) * 1000.0 };
+
+        FString fileName{ FString::Printf(TEXT("Seed_%i.labyrinth"), params.Seed) };
+        bool saved{ generated && (statsOnly || FLabyrinthLayoutFile::Save(layout, FPaths::Combine(outputDirectory, fileName))) };
+
+        if (!saved)
+        {
+            numFailed++;
+        }
+
+        FLabyrinthGenSeedStats& stats = seedStats[index];
+        stats.Seed = params.Seed;
+        stats.Succeeded = saved;
+        stats.LayoutHash = FString::Printf(TEXT("%08x"), layout.ComputeHash());
+        stats.RoomsPlaced = layout.Rooms.Num();
+        stats.UnconnectedRooms = generator.GetStats().NumUnconnectedRooms;
+        stats.HallCells = layout.HallCells.Num();
+        stats.OpenDoors = layout.OpenDoors.CountSetBits();
+        stats.WallFaces = layout.NumWallFaces;
+        stats.WallPieces = layout.WallRuns.Num();
+        stats.GenerationMs = generateMs;
+        stats.File = (saved && !statsOnly) ? fileName : FString{};
+    });
+
+    TArray<FString> statsLines;
+    for (const FLabyrinthGenSeedStats& stats : seedStats)
+    {
+        FString& json = statsLines.AddDefaulted_GetRef();
+        FJsonObjectConverter::UStructToJsonObjectString(stats, json, 0, 0, 0, nullptr, false);
+    }
+
+    FString statsPath{ FPaths::Combine(outputDirectory, TEXT("stats.jsonl")) };
+    if (!FFileHelper::SaveStringArrayToFile(statsLines, *statsPath))
+    {
+        UE_LOG(LogLabyrinthGen, Error, TEXT("Could not write %s"), *statsPath);
+        return 1;
+    }
+
+    UE_LOG(LogLabyrinthGen, Display, TEXT("Generated %i seeds in %.2f s on %i workers, %i failed. Stats in %s"),
+        numSeeds, FPlatformTime::Seconds() - startTime, generators.Num(), numFailed.load(), *statsPath);
+
+    return numFailed.load() == 0 ? 0 : 1;
+}
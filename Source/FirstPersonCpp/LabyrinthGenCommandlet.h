@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "LabyrinthGenCommandlet.generated.h"
+
+/**
+ * One seed's line in stats.jsonl.
+ */
+USTRUCT()
+struct FLabyrinthGenSeedStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Seed = 0;
+
+	// Generated, and saved unless -StatsOnly
+	UPROPERTY()
+	bool Succeeded = false;
+
+	// FLabyrinthLayout::ComputeHash as eight hex digits
+	UPROPERTY()
+	FString LayoutHash;
+
+	UPROPERTY()
+	int32 RoomsPlaced = 0;
+
+	// Rooms placed without a hallway to the rest of the labyrinth
+	UPROPERTY()
+	int32 UnconnectedRooms = 0;
+
+	UPROPERTY()
+	int32 HallCells = 0;
+
+	UPROPERTY()
+	int32 OpenDoors = 0;
+
+	UPROPERTY()
+	int32 WallFaces = 0;
+
+	UPROPERTY()
+	int32 WallPieces = 0;
+
+	UPROPERTY()
+	float GenerationMs = 0.0f;
+
+	// Layout file in the output directory. Empty with -StatsOnly or when the layout was not saved.
+	UPROPERTY()
+	FString File;
+};
+
+/**
+ * Generates labyrinth layouts for a range of seeds without a world, in parallel across all cores.
+ * Writes one layout file per seed and one JSON stats line per seed to stats.jsonl.
+ *
+ * UnrealEditor-Cmd.exe FirstPersonCpp.uproject -run=LabyrinthGen
+ *     -FirstSeed=0 -NumSeeds=1000 -Dimensions=40x40 -Rooms=8 -CellUnit=2.0
+ *     -Room=/Game/Labyrinth/Blueprints/Room.Room_C -Strategy=SearchRays -CandidateRays=1 -RoomBatch=1
+ *     -Output=<directory> [-Wavefront] [-ParallelMinCells=<cells>] [-MergeWalls] [-StatsOnly]
+ *
+ * The generator options are read like the benchmark's, and -Room defaults to the project's room blueprint.
+ * Output defaults to Saved/Labyrinths.
+ */
+UCLASS()
+class ULabyrinthGenCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	ULabyrinthGenCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
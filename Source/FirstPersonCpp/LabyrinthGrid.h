@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Row-major 2D grid backed by a single contiguous allocation.
+ * Cell (x, y) is stored at index (y * Width + x), so walking a row touches adjacent memory.
+ */
+template<typename ElementType>
+class TLabyrinthGrid
+{
+public:
+	TLabyrinthGrid() = default;
+
+	// Resize the grid to the given dimensions and fill every cell with value.
+	// The existing allocation is reused when the cell count does not change.
+	void Init(FIntVector2 dimensions, const ElementType& value)
+	{
+		Width = FMath::Max(dimensions.X, 0);
+		Height = FMath::Max(dimensions.Y, 0);
+		Cells.Init(value, Width * Height);
+	}
+
+	void Fill(const ElementType& value)
+	{
+		for (ElementType& cell : Cells)
+		{
+			cell = value;
+		}
+	}
+
+	int32 GetWidth() const { return Width; }
+	int32 GetHeight() const { return Height; }
+	FIntVector2 GetDimensions() const { return FIntVector2{ Width, Height }; }
+	int32 Num() const { return Cells.Num(); }
+
+	bool IsInBounds(FIntVector2 cell) const
+	{
+		return
+			(cell.X >= 0) &&
+			(cell.Y >= 0) &&
+			(cell.X < Width) &&
+			(cell.Y < Height);
+	}
+
+	int32 ToIndex(FIntVector2 cell) const { return (cell.Y * Width) + cell.X; }
+	FIntVector2 ToCell(int32 index) const { return FIntVector2{ index % Width, index / Width }; }
+
+	ElementType& operator[](FIntVector2 cell)
+	{
+		checkSlow(IsInBounds(cell));
+		return Cells[ToIndex(cell)];
+	}
+
+	const ElementType& operator[](FIntVector2 cell) const
+	{
+		checkSlow(IsInBounds(cell));
+		return Cells[ToIndex(cell)];
+	}
+
+	ElementType& operator[](int32 index) { return Cells[index]; }
+	const ElementType& operator[](int32 index) const { return Cells[index]; }
+
+	TArrayView<ElementType> GetRow(int32 y)
+	{
+		checkSlow(y >= 0 && y < Height);
+		return TArrayView<ElementType>(Cells.GetData() + (y * Width), Width);
+	}
+
+	TConstArrayView<ElementType> GetRow(int32 y) const
+	{
+		checkSlow(y >= 0 && y < Height);
+		return TConstArrayView<ElementType>(Cells.GetData() + (y * Width), Width);
+	}
+
+	ElementType* GetData() { return Cells.GetData(); }
+	const ElementType* GetData() const { return Cells.GetData(); }
+
+	SIZE_T GetAllocatedSize() const { return Cells.GetAllocatedSize(); }
+
+private:
+	TArray<ElementType> Cells;
+	int32 Width = 0;
+	int32 Height = 0;
+};
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Walks the cells a ray passes through, one cell per Step, with only integer adds and compares (Amanatides and Woo).
+ * The ray leaves from the center of its start cell. Its direction is quantized to fixed point once up front, so a
+ * direction always walks the same cells, and directions along an axis need no special case.
+ */
+class FLabyrinthGridRay
+{
+public:
+	FLabyrinthGridRay(FIntVector2 start, FVector2D direction)
+		: Cell{ start }
+	{
+		int64 directionX{ FMath::RoundToInt64(direction.X * DirectionScale) };
+		int64 directionY{ FMath::RoundToInt64(direction.Y * DirectionScale) };
+
+		// A zero direction still has to go somewhere.
+		if (directionX == 0 && directionY == 0)
+		{
+			directionX = DirectionScale;
+		}
+
+		StepX = directionX < 0 ? -1 : 1;
+		StepY = directionY < 0 ? -1 : 1;
+
+		DeltaX = FMath::Abs(directionY) * 2;
+		DeltaY = FMath::Abs(directionX) * 2;
+
+		// The ray crosses its i-th x boundary at t = (2i + 1) / (2 |x|). Scaling every crossing by 2 |x| |y| leaves
+		// x crossings at (2i + 1) |y| and y crossings at (2j + 1) |x|, which compare without dividing.
+		NextCrossingX = FMath::Abs(directionY);
+		NextCrossingY = FMath::Abs(directionX);
+	}
+
+	FIntVector2 GetCell() const { return Cell; }
+
+	// Move into the next cell the ray enters. At an exact corner the x step is taken first.
+	void Step()
+	{
+		if (NextCrossingX <= NextCrossingY)
+		{
+			Cell.X += StepX;
+			NextCrossingX += DeltaX;
+		}
+		else
+		{
+			Cell.Y += StepY;
+			NextCrossingY += DeltaY;
+		}
+	}
+
+private:
+	static constexpr int64 DirectionScale = 1 << 16;
+
+	FIntVector2 Cell;
+
+	int32 StepX = 1;
+	int32 StepY = 1;
+
+	int64 NextCrossingX = 0;
+	int64 NextCrossingY = 0;
+	int64 DeltaX = 0;
+	int64 DeltaY = 0;
+};
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthPlacementStrategy.h"
+
+/**
+ * Everything needed to generate a labyrinth layout. Plain data, so layouts can be generated without a world.
+ */
+struct FLabyrinthLayoutParams
+{
+	int32 Seed = 0;
+
+	FIntVector2 Dimensions{ 40, 40 };
+
+	int32 NumberOfRooms = 8;
+
+	// Meters per cell
+	double CellUnit = 2.0;
+
+	// Size of every room in cells
+	FIntVector2 RoomCellSize{ 1, 1 };
+
+	// Door transforms relative to the room's minimum corner. Forward points out of the room.
+	TArray<FTransform> RoomDoors;
+
+	// Only flood the distance field from cells added since the last update.
+	bool bIncrementalDistanceField = true;
+
+	// Flood the distance field with the bit-parallel wavefront instead of the cell queue. The distances are identical.
+	bool bWavefrontDistanceField = false;
+
+	// Labyrinths with at least this many cells flood the distance field across worker threads. Zero or less never does.
+	int32 ParallelDistanceFieldMinCells = 2048 * 2048;
+
+	// Merge collinear hallway wall faces into runs.
+	bool bMergeHallwayWalls = false;
+
+	ELabyrinthPlacementStrategy PlacementStrategy = ELabyrinthPlacementStrategy::SearchRays;
+
+	// Search rays walked at once for each room, on worker threads. The shortest successful walk places the room.
+	int32 NumCandidateRays = 1;
+
+	// With search rays, rooms proposed at once and placed together before a single distance field update.
+	// Proposals that overlap an earlier proposal's room or doors wait for the next batch.
+	int32 RoomBatchSize = 1;
+};
+
+/**
+ * A straight run of hallway wall faces that all point the same way.
+ * Unmerged walls are runs of length one.
+ */
+struct FLabyrinthWallRun
+{
+	FIntVector2 FirstCell{ 0, 0 };
+	FIntVector2 LastCell{ 0, 0 };
+
+	// Direction from the hall cells towards the wall
+	FIntVector2 Direction{ 0, 0 };
+
+	int32 Length() const
+	{
+		return FMath::Max(FMath::Abs(LastCell.X - FirstCell.X), FMath::Abs(LastCell.Y - FirstCell.Y)) + 1;
+	}
+};
+
+/**
+ * A finished labyrinth as plain data: rooms, hall cells, door states and walls, all in cell coordinates.
+ */
+struct FLabyrinthLayout
+{
+	int32 Seed = 0;
+	FIntVector2 Dimensions{ 0, 0 };
+	double CellUnit = 2.0;
+	FIntVector2 RoomCellSize{ 1, 1 };
+	TArray<FTransform> RoomDoors;
+
+	// Minimum corner of each room, in placement order
+	TArray<FIntVector2> Rooms;
+
+	// One bit per room door, indexed by (room * doors per room + door). Set when a hallway reaches the door.
+	TBitArray<> OpenDoors;
+
+	// Hall cells in the order they were carved
+	TArray<FIntVector2> HallCells;
+
+	TArray<FLabyrinthWallRun> WallRuns;
+
+	// Number of single cell wall faces before any merging
+	int32 NumWallFaces = 0;
+
+	// Clear all contents and copy the describing parameters.
+	void Reset(const FLabyrinthLayoutParams& params)
+	{
+		Seed = params.Seed;
+		Dimensions = params.Dimensions;
+		CellUnit = params.CellUnit;
+		RoomCellSize = params.RoomCellSize;
+		RoomDoors = params.RoomDoors;
+
+		Rooms.Reset();
+		OpenDoors.Reset();
+		HallCells.Reset();
+		WallRuns.Reset();
+		NumWallFaces = 0;
+	}
+
+	int32 GetDoorsPerRoom() const { return RoomDoors.Num(); }
+
+	bool IsDoorOpen(int32 roomIndex, int32 doorIndex) const
+	{
+		return OpenDoors[(roomIndex * GetDoorsPerRoom()) + doorIndex];
+	}
+
+	// Checksum of the generated contents. Equal seeds and parameters give equal hashes on every machine.
+	uint32 ComputeHash() const
+	{
+		// Bits past the end of a TBitArray are kept clear, so whole words can be hashed.
+		int32 numDoorWords{ FMath::DivideAndRoundUp(OpenDoors.Num(), static_cast<int32>(NumBitsPerDWORD)) };
+		return ComputeHash(Seed, Dimensions, Rooms, HallCells, WallRuns, TConstArrayView<uint32>(OpenDoors.GetData(), numDoorWords));
+	}
+
+	// The same checksum over contents held elsewhere, such as the sections of a layout file.
+	static uint32 ComputeHash(int32 seed, FIntVector2 dimensions, TConstArrayView<FIntVector2> rooms, TConstArrayView<FIntVector2> hallCells,
+		TConstArrayView<FLabyrinthWallRun> wallRuns, TConstArrayView<uint32> openDoorWords)
+	{
+		uint32 hash{ FCrc::MemCrc32(&dimensions, sizeof(dimensions), static_cast<uint32>(seed)) };
+		hash = FCrc::MemCrc32(rooms.GetData(), rooms.Num() * sizeof(FIntVector2), hash);
+		hash = FCrc::MemCrc32(hallCells.GetData(), hallCells.Num() * sizeof(FIntVector2), hash);
+		hash = FCrc::MemCrc32(wallRuns.GetData(), wallRuns.Num() * sizeof(FLabyrinthWallRun), hash);
+		return FCrc::MemCrc32(openDoorWords.GetData(), openDoorWords.Num() * sizeof(uint32), hash);
+	}
+};
@@ -0,0 +1,325 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthLayoutFile.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+    constexpr uint64 SectionAlignment = 8;
+
+    uint64 AlignSection(uint64 offset)
+    {
+        return Align(offset, SectionAlignment);
+    }
+
+    uint64 GetCellsSize(const FLabyrinthLayoutFileHeader& header)
+    {
+        return static_cast<uint64>(header.CellWordsPerRow) * header.Dimensions.Y * sizeof(uint64);
+    }
+
+    // MemCrc32 takes an int32 length, so very large cell sections are hashed in pieces.
+    uint32 ComputeCellsCrc(const uint8* cells, uint64 size)
+    {
+        uint32 crc{ 0 };
+        for (uint64 offset = 0; offset < size; offset += MAX_int32)
+        {
+            crc = FCrc::MemCrc32(cells + offset, static_cast<int32>(FMath::Min<uint64>(size - offset, MAX_int32)), crc);
+        }
+        return crc;
+    }
+}
+
+FLabyrinthLayoutFile::FLabyrinthLayoutFile() = default;
+
+FLabyrinthLayoutFile::~FLabyrinthLayoutFile()
+{
+    Close();
+}
+
+bool FLabyrinthLayoutFile::Save(const FLabyrinthLayout& layout, const FString& path)
+{
+    TArray64<uint8> bytes;
+    Write(layout, bytes);
+
+    return FFileHelper::SaveArrayToFile(bytes, *path);
+}
+
+void FLabyrinthLayoutFile::Write(const FLabyrinthLayout& layout, TArray64<uint8>& outBytes)
+{
+    FLabyrinthLayoutFileHeader header{};
+    header.LayoutHash = layout.ComputeHash();
+    header.Seed = layout.Seed;
+    header.Dimensions = layout.Dimensions;
+    header.RoomCellSize = layout.RoomCellSize;
+    header.CellUnit = layout.CellUnit;
+    header.NumRooms = layout.Rooms.Num();
+    header.DoorsPerRoom = layout.GetDoorsPerRoom();
+    header.NumWallRuns = layout.WallRuns.Num();
+    header.NumWallFaces = layout.NumWallFaces;
+    header.NumHallCells = layout.HallCells.Num();
+    header.CellWordsPerRow = FMath::DivideAndRoundUp(layout.Dimensions.X, CellsPerWord);
+
+    int32 numDoorWords{ FMath::DivideAndRoundUp(layout.OpenDoors.Num(), static_cast<int32>(NumBitsPerDWORD)) };
+
+    header.CellsOffset = AlignSection(sizeof(FLabyrinthLayoutFileHeader));
+    header.RoomsOffset = AlignSection(header.CellsOffset + GetCellsSize(header));
+    header.HallCellsOffset = AlignSection(header.RoomsOffset + (layout.Rooms.Num() * sizeof(FIntVector2)));
+    header.DoorsOffset = AlignSection(header.HallCellsOffset + (layout.HallCells.Num() * sizeof(FIntVector2)));
+    header.WallRunsOffset = AlignSection(header.DoorsOffset + (numDoorWords * sizeof(uint32)));
+    header.FileSize = AlignSection(header.WallRunsOffset + (layout.WallRuns.Num() * sizeof(FLabyrinthWallRun)));
+
+    outBytes.Reset();
+    outBytes.SetNumZeroed(header.FileSize);
+
+    uint64* cellWords = reinterpret_cast<uint64*>(outBytes.GetData() + header.CellsOffset);
+    auto setCell = [&header, cellWords](FIntVector2 cell, ELabyrinthCellType type)
+    {
+        uint64& word = cellWords[(cell.Y * header.CellWordsPerRow) + (cell.X / CellsPerWord)];
+        int32 shift{ (cell.X % CellsPerWord) * 2 };
+        word = (word & ~(uint64{ 3 } << shift)) | (static_cast<uint64>(type) << shift);
+    };
+
+    for (FIntVector2 room : layout.Rooms)
+    {
+        for (int32 y = 0; y < layout.RoomCellSize.Y; y++)
+        {
+            for (int32 x = 0; x < layout.RoomCellSize.X; x++)
+            {
+                setCell(room + FIntVector2{ x, y }, ELabyrinthCellType::Room);
+            }
+        }
+    }
+
+    for (FIntVector2 hallCell : layout.HallCells)
+    {
+        setCell(hallCell, ELabyrinthCellType::Hall);
+    }
+
+    header.CellsCrc = ComputeCellsCrc(outBytes.GetData() + header.CellsOffset, GetCellsSize(header));
+
+    FMemory::Memcpy(outBytes.GetData(), &header, sizeof(header));
+    FMemory::Memcpy(outBytes.GetData() + header.RoomsOffset, layout.Rooms.GetData(), layout.Rooms.Num() * sizeof(FIntVector2));
+    FMemory::Memcpy(outBytes.GetData() + header.HallCellsOffset, layout.HallCells.GetData(), layout.HallCells.Num() * sizeof(FIntVector2));
+    FMemory::Memcpy(outBytes.GetData() + header.DoorsOffset, layout.OpenDoors.GetData(), numDoorWords * sizeof(uint32));
+    FMemory::Memcpy(outBytes.GetData() + header.WallRunsOffset, layout.WallRuns.GetData(), layout.WallRuns.Num() * sizeof(FLabyrinthWallRun));
+}
+
+bool FLabyrinthLayoutFile::Open(const FString& path, bool bVerifyChecksums)
+{
+    Close();
+    Path = path;
+
+    // Mapping fails for files that are compressed or inside a pak, so fall back to reading the file.
+    MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*path));
+    if (MappedFile.IsValid() && MappedFile->GetFileSize() >= static_cast<int64>(sizeof(FLabyrinthLayoutFileHeader)))
+    {
+        MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+    }
+
+    if (MappedRegion.IsValid())
+    {
+        Data = MappedRegion->GetMappedPtr();
+        DataSize = MappedRegion->GetMappedSize();
+    }
+    else
+    {
+        MappedFile.Reset();
+
+        if (!FFileHelper::LoadFileToArray(LoadedBytes, *path, FILEREAD_Silent))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Could not open labyrinth layout file %s"), *path);
+            return false;
+        }
+
+        Data = LoadedBytes.GetData();
+        DataSize = LoadedBytes.Num();
+    }
+
+    if (!ValidateStructure() || (bVerifyChecksums && !VerifyChecksums()))
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void FLabyrinthLayoutFile::Close()
+{
+    // The region has to go before the handle it was mapped from.
+    MappedRegion.Reset();
+    MappedFile.Reset();
+    LoadedBytes.Empty();
+
+    Data = nullptr;
+    DataSize = 0;
+    Path.Reset();
+}
+
+bool FLabyrinthLayoutFile::ValidateStructure() const
+{
+    if (DataSize < static_cast<int64>(sizeof(FLabyrinthLayoutFileHeader)))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Labyrinth layout file %s is too small"), *Path);
+        return false;
+    }
+
+    const FLabyrinthLayoutFileHeader& header = GetHeader();
+
+    if (header.Magic != FLabyrinthLayoutFileHeader::ExpectedMagic)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("%s is not a labyrinth layout file"), *Path);
+        return false;
+    }
+
+    if (header.Version != FLabyrinthLayoutFileHeader::CurrentVersion)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Labyrinth layout file %s has version %u, expected %u"), *Path, header.Version, FLabyrinthLayoutFileHeader::CurrentVersion);
+        return false;
+    }
+
+    bool countsValid{
+        header.Dimensions.X > 0 && header.Dimensions.Y > 0 &&
+        header.RoomCellSize.X > 0 && header.RoomCellSize.Y > 0 &&
+        header.NumRooms >= 0 && header.DoorsPerRoom >= 0 && header.NumHallCells >= 0 && header.NumWallRuns >= 0 &&
+        header.CellWordsPerRow == FMath::DivideAndRoundUp(header.Dimensions.X, CellsPerWord) };
+
+    // Only multiply once the counts are known to be non negative. Door bits are indexed with int32 when reading.
+    const int64 numDoorBits{ countsValid ? static_cast<int64>(header.NumRooms) * header.DoorsPerRoom : 0 };
+    const uint64 numDoorWords{ static_cast<uint64>(FMath::DivideAndRoundUp(numDoorBits, static_cast<int64>(NumBitsPerDWORD))) };
+
+    // Offsets are checked against the file size first, so adding section sizes to them cannot wrap.
+    bool sectionsValid{ countsValid && numDoorBits <= MAX_int32 &&
+        header.FileSize <= static_cast<uint64>(DataSize) &&
+        header.CellsOffset <= header.FileSize && header.RoomsOffset <= header.FileSize && header.HallCellsOffset <= header.FileSize &&
+        header.DoorsOffset <= header.FileSize && header.WallRunsOffset <= header.FileSize &&
+        header.CellsOffset >= sizeof(FLabyrinthLayoutFileHeader) &&
+        header.CellsOffset % SectionAlignment == 0 && header.RoomsOffset % SectionAlignment == 0 && header.HallCellsOffset % SectionAlignment == 0 &&
+        header.DoorsOffset % SectionAlignment == 0 && header.WallRunsOffset % SectionAlignment == 0 &&
+        header.RoomsOffset >= header.CellsOffset + GetCellsSize(header) &&
+        header.HallCellsOffset >= header.RoomsOffset + (header.NumRooms * sizeof(FIntVector2)) &&
+        header.DoorsOffset >= header.HallCellsOffset + (header.NumHallCells * sizeof(FIntVector2)) &&
+        header.WallRunsOffset >= header.DoorsOffset + (numDoorWords * sizeof(uint32)) &&
+        header.FileSize >= header.WallRunsOffset + (header.NumWallRuns * sizeof(FLabyrinthWallRun)) };
+
+    if (!sectionsValid)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Labyrinth layout file %s is truncated or corrupt"), *Path);
+        return false;
+    }
+
+    // Rooms and hall cells are spawned straight from their coordinates, so every one has to be inside the labyrinth.
+    for (FIntVector2 room : GetRooms())
+    {
+        if (room.X < 0 || room.Y < 0 ||
+            room.X > header.Dimensions.X - header.RoomCellSize.X || room.Y > header.Dimensions.Y - header.RoomCellSize.Y)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Labyrinth layout file %s has a room at %i, %i outside the labyrinth"), *Path, room.X, room.Y);
+            return false;
+        }
+    }
+
+    for (FIntVector2 hallCell : GetHallCells())
+    {
+        if (hallCell.X < 0 || hallCell.Y < 0 || hallCell.X >= header.Dimensions.X || hallCell.Y >= header.Dimensions.Y)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Labyrinth layout file %s has a hall cell at %i, %i outside the labyrinth"), *Path, hallCell.X, hallCell.Y);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool FLabyrinthLayoutFile::VerifyChecksums() const
+{
+    if (!IsOpen())
+    {
+        return false;
+    }
+
+    const FLabyrinthLayoutFileHeader& header = GetHeader();
+
+    if (ComputeCellsCrc(Data + header.CellsOffset, GetCellsSize(header)) != header.CellsCrc)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Labyrinth layout file %s has corrupt cells"), *Path);
+        return false;
+    }
+
+    const int32 numDoorWords{ FMath::DivideAndRoundUp(header.NumRooms * header.DoorsPerRoom, static_cast<int32>(NumBitsPerDWORD)) };
+    TConstArrayView<uint32> openDoorWords{ GetSection<uint32>(header.DoorsOffset), numDoorWords };
+    uint32 layoutHash{ FLabyrinthLayout::ComputeHash(header.Seed, header.Dimensions, GetRooms(), GetHallCells(), GetWallRuns(), openDoorWords) };
+    if (layoutHash != header.LayoutHash)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Labyrinth layout file %s has hash %08x, expected %08x"), *Path, layoutHash, header.LayoutHash);
+        return false;
+    }
+
+    return true;
+}
+
+ELabyrinthCellType FLabyrinthLayoutFile::GetCellType(FIntVector2 cell) const
+{
+    const FLabyrinthLayoutFileHeader& header = GetHeader();
+    if (cell.X < 0 || cell.Y < 0 || cell.X >= header.Dimensions.X || cell.Y >= header.Dimensions.Y)
+    {
+        return ELabyrinthCellType::Empty;
+    }
+
+    uint64 word{ GetSection<uint64>(header.CellsOffset)[(cell.Y * header.CellWordsPerRow) + (cell.X / CellsPerWord)] };
+    return static_cast<ELabyrinthCellType>((word >> ((cell.X % CellsPerWord) * 2)) & 3);
+}
+
+TConstArrayView<FIntVector2> FLabyrinthLayoutFile::GetRooms() const
+{
+    return TConstArrayView<FIntVector2>(GetSection<FIntVector2>(GetHeader().RoomsOffset), GetHeader().NumRooms);
+}
+
+TConstArrayView<FIntVector2> FLabyrinthLayoutFile::GetHallCells() const
+{
+    return TConstArrayView<FIntVector2>(GetSection<FIntVector2>(GetHeader().HallCellsOffset), GetHeader().NumHallCells);
+}
+
+TConstArrayView<FLabyrinthWallRun> FLabyrinthLayoutFile::GetWallRuns() const
+{
+    return TConstArrayView<FLabyrinthWallRun>(GetSection<FLabyrinthWallRun>(GetHeader().WallRunsOffset), GetHeader().NumWallRuns);
+}
+
+bool FLabyrinthLayoutFile::IsDoorOpen(int32 roomIndex, int32 doorIndex) const
+{
+    int32 doorBit{ (roomIndex * GetHeader().DoorsPerRoom) + doorIndex };
+    uint32 word{ GetSection<uint32>(GetHeader().DoorsOffset)[doorBit / NumBitsPerDWORD] };
+    return (word >> (doorBit % NumBitsPerDWORD)) & 1;
+}
+
+void FLabyrinthLayoutFile::CopyToLayout(FLabyrinthLayout& outLayout, const TArray<FTransform>& roomDoors) const
+{
+    const FLabyrinthLayoutFileHeader& header = GetHeader();
+
+    FLabyrinthLayoutParams params{};
+    params.Seed = header.Seed;
+    params.Dimensions = header.Dimensions;
+    params.CellUnit = header.CellUnit;
+    params.RoomCellSize = header.RoomCellSize;
+    params.RoomDoors = roomDoors;
+    outLayout.Reset(params);
+
+    outLayout.Rooms.Append(GetRooms().GetData(), GetRooms().Num());
+    outLayout.HallCells.Append(GetHallCells().GetData(), GetHallCells().Num());
+    outLayout.WallRuns.Append(GetWallRuns().GetData(), GetWallRuns().Num());
+    outLayout.NumWallFaces = header.NumWallFaces;
+
+    // Only as many doors as the file recorded can be open. Extra doors on the room class stay closed.
+    outLayout.OpenDoors.Init(false, header.NumRooms * roomDoors.Num());
+    int32 sharedDoors{ FMath::Min(header.DoorsPerRoom, roomDoors.Num()) };
+    for (int32 roomIndex = 0; roomIndex < header.NumRooms; roomIndex++)
+    {
+        for (int32 doorIndex = 0; doorIndex < sharedDoors; doorIndex++)
+        {
+            outLayout.OpenDoors[(roomIndex * roomDoors.Num()) + doorIndex] = IsDoorOpen(roomIndex, doorIndex);
+        }
+    }
+}
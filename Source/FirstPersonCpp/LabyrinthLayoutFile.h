@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthLayout.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// What occupies a cell in a layout file. Two bits per cell.
+enum class ELabyrinthCellType : uint8
+{
+	Empty = 0,
+	Room = 1,
+	Hall = 2
+};
+
+/**
+ * Fixed size header at the start of a layout file. Every section offset is from the start of the file and 8 byte aligned.
+ *
+ * Sections:
+ *   Cells      rows of uint64 words, 32 two bit ELabyrinthCellType values per word, each row starting on a new word.
+ *              Only used for cell lookups, the layout itself comes from the other sections.
+ *   Rooms      NumRooms FIntVector2 minimum corners, in placement order
+ *   HallCells  NumHallCells FIntVector2 cells, in carve order
+ *   Doors      uint32 words of door bits indexed by (room * DoorsPerRoom + door), set when the door is open
+ *   WallRuns   NumWallRuns FLabyrinthWallRun records
+ */
+struct FLabyrinthLayoutFileHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x5259424C; // "LBYR"
+	static constexpr uint32 CurrentVersion = 2;
+
+	uint32 Magic = ExpectedMagic;
+	uint32 Version = CurrentVersion;
+
+	// Checksum of the layout that was saved, from FLabyrinthLayout::ComputeHash. Checked against the sections on open.
+	uint32 LayoutHash = 0;
+	int32 Seed = 0;
+
+	FIntVector2 Dimensions{ 0, 0 };
+	FIntVector2 RoomCellSize{ 1, 1 };
+	double CellUnit = 2.0;
+
+	int32 NumRooms = 0;
+	int32 DoorsPerRoom = 0;
+	int32 NumWallRuns = 0;
+	int32 NumWallFaces = 0;
+	int32 NumHallCells = 0;
+
+	int32 CellWordsPerRow = 0;
+
+	// Checksum of the cell section, which the layout hash does not cover
+	uint32 CellsCrc = 0;
+	uint32 Padding = 0;
+
+	uint64 CellsOffset = 0;
+	uint64 RoomsOffset = 0;
+	uint64 HallCellsOffset = 0;
+	uint64 DoorsOffset = 0;
+	uint64 WallRunsOffset = 0;
+	uint64 FileSize = 0;
+};
+
+/**
+ * Read only view of a layout file. The file is memory mapped where the platform allows it and loaded into memory otherwise
+ * (for example from a pak). Either way every accessor reads straight from the file's bytes, there is no parse step.
+ */
+class FIRSTPERSONCPP_API FLabyrinthLayoutFile
+{
+public:
+	static constexpr int32 CellsPerWord = 32;
+
+	FLabyrinthLayoutFile();
+	~FLabyrinthLayoutFile();
+
+	FLabyrinthLayoutFile(const FLabyrinthLayoutFile&) = delete;
+	FLabyrinthLayoutFile& operator=(const FLabyrinthLayoutFile&) = delete;
+
+	// Save a layout in the file format. Returns false if the file could not be written.
+	static bool Save(const FLabyrinthLayout& layout, const FString& path);
+
+	// Serialize a layout in the file format.
+	static void Write(const FLabyrinthLayout& layout, TArray64<uint8>& outBytes);
+
+	// Map or load a file and check its header, section bounds and room and hall coordinates. Returns false if it is missing
+	// or not a valid layout. With bVerifyChecksums the checksums are checked too, which reads the whole file once.
+	bool Open(const FString& path, bool bVerifyChecksums = true);
+	void Close();
+
+	// Check the cell checksum and layout hash of an open file, for files opened without them.
+	bool VerifyChecksums() const;
+
+	bool IsOpen() const { return Data != nullptr; }
+	bool IsMapped() const { return MappedRegion.IsValid(); }
+
+	const FLabyrinthLayoutFileHeader& GetHeader() const { return *reinterpret_cast<const FLabyrinthLayoutFileHeader*>(Data); }
+
+	ELabyrinthCellType GetCellType(FIntVector2 cell) const;
+
+	TConstArrayView<FIntVector2> GetRooms() const;
+	TConstArrayView<FIntVector2> GetHallCells() const;
+	TConstArrayView<FLabyrinthWallRun> GetWallRuns() const;
+
+	bool IsDoorOpen(int32 roomIndex, int32 doorIndex) const;
+
+	// Fill a layout from the file for spawning. roomDoors are the door transforms of the room class the file is spawned with.
+	// With the room class the file was saved with, the copy has the same hash as the saved layout.
+	void CopyToLayout(FLabyrinthLayout& outLayout, const TArray<FTransform>& roomDoors) const;
+
+private:
+	// Everything that has to hold before the sections can be read safely
+	bool ValidateStructure() const;
+
+	template<typename RecordType>
+	const RecordType* GetSection(uint64 offset) const { return reinterpret_cast<const RecordType*>(Data + offset); }
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	// Used when the file cannot be mapped
+	TArray64<uint8> LoadedBytes;
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+
+	// For warnings
+	FString Path;
+};
@@ -0,0 +1,860 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthLayoutGenerator.h"
+
+#include <limits>
+
+#include "Async/ParallelFor.h"
+#include "ProfilingDebugging/ScopedTimers.h"
+
+#include "LabyrinthGridRay.h"
+#include "LabyrinthStats.h"
+
+namespace
+{
+    // Search rays cannot tell a full labyrinth from unlucky directions, so give up after this many misses in a row.
+    constexpr int32 MaxConsecutiveFailedSearchPaths{ 1000 };
+}
+
+bool FLabyrinthLayoutGenerator::Generate(const FLabyrinthLayoutParams& params, FLabyrinthLayout& outLayout, const std::atomic<bool>* cancelRequested)
+{
+    Stats = FLabyrinthGenerationStats{};
+    SET_DWORD_STAT(STAT_LabyrinthCellsVisited, 0);
+    SET_DWORD_STAT(STAT_LabyrinthSearchPathSteps, 0);
+    SET_DWORD_STAT(STAT_LabyrinthFailedPlacements, 0);
+    FScopedDurationTimer totalTimer{ Stats.TotalSeconds };
+
+    Params = params;
+    Converter = CellUnitConverter(Params.CellUnit);
+
+    outLayout.Reset(Params);
+
+    ZeroDistanceCoordinates.Reset();
+    ZeroDistanceMembership.Init(Params.Dimensions);
+    NextDistanceFieldSeedIndex = 0;
+
+    DistanceField.Init(Params.Dimensions);
+
+    // Only the search rays read the blocked area table, and it is an int32 per cell.
+    if (Params.PlacementStrategy == ELabyrinthPlacementStrategy::SearchRays)
+    {
+        BlockedArea.Init(Params.Dimensions);
+    }
+    else if (Params.PlacementStrategy == ELabyrinthPlacementStrategy::EmptySquares)
+    {
+        EmptySquares.Init(Params.Dimensions, Params.RoomCellSize);
+    }
+
+    ScratchArena.ResetAllocationCount();
+    ScratchArena.Prepare(Params.Dimensions);
+
+    if (Params.NumberOfRooms < 1)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Tried to build labyrinth with %i rooms"), Params.NumberOfRooms);
+        return false;
+    }
+
+    if (Params.RoomCellSize.X < 1 || Params.RoomCellSize.Y < 1 ||
+        !AreRoomExtentsWithinLabyrinth(FIntVector2{ 0, 0 }, Params.RoomCellSize.X, Params.RoomCellSize.Y))
+    {
+        UE_LOG(LogTemp, Log, TEXT("Rooms of %i x %i cells do not fit a %i x %i labyrinth"),
+            Params.RoomCellSize.X, Params.RoomCellSize.Y, Params.Dimensions.X, Params.Dimensions.Y);
+        return false;
+    }
+
+    RandomStream.Initialize(Params.Seed);
+
+    Layout = &outLayout;
+    CancelRequested = cancelRequested;
+
+    {
+        FScopedDurationTimer placementTimer{ Stats.RoomPlacementSeconds };
+        PlaceRooms();
+    }
+    Stats.RoomPlacementSeconds -= Stats.DistanceFieldSeconds + Stats.CorridorSeconds;
+
+    bool cancelled{ IsCancelRequested() };
+    if (!cancelled)
+    {
+        {
+            FScopedDurationTimer doorTimer{ Stats.DoorSeconds };
+            FindDoorStates();
+        }
+
+        FScopedDurationTimer wallTimer{ Stats.WallSeconds };
+        FindHallwayWalls();
+    }
+
+    Stats.NumScratchAllocations = ScratchArena.GetNumAllocations();
+    Stats.AllocatedBytes = DistanceField.GetAllocatedSize() + BlockedArea.GetAllocatedSize() + BitboardPlacer.GetAllocatedSize() + EmptySquares.GetAllocatedSize() + ScratchArena.GetAllocatedSize() +
+        ZeroDistanceCoordinates.GetAllocatedSize() + ZeroDistanceMembership.GetAllocatedSize();
+
+    Layout = nullptr;
+    CancelRequested = nullptr;
+
+    return !cancelled;
+}
+
+void FLabyrinthLayoutGenerator::PlaceRooms()
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(Labyrinth_PlaceRooms);
+    SCOPE_CYCLE_COUNTER(STAT_LabyrinthPlaceRooms);
+
+    PlaceFirstRoom();
+    RecalculateDistanceField();
+
+    int numToSpawn{ Params.NumberOfRooms - 1 };
+    int32 consecutiveFailedSearchPaths{ 0 };
+
+    while (numToSpawn > 0 && !IsCancelRequested())
+    {
+        // Pick a random direction. Drawn from the seeded stream so a seed always reproduces the same layout.
+        FVector2D direction{
+            RandomStream.FRandRange(-1.0, 1.0) ,
+            RandomStream.FRandRange(-1.0, 1.0) };
+
+        FIntVector2 potentialRoomCoordinates{};
+
+        if (Params.RoomBatchSize > 1 && Params.PlacementStrategy == ELabyrinthPlacementStrategy::SearchRays)
+        {
+            int32 numPlaced{ PlaceRoomBatch(direction, numToSpawn) };
+            if (numPlaced == 0)
+            {
+                UE_LOG(LogTemp, Log, TEXT("LabyrinthBuilder could not spawn any room of a batch! Trying new paths."));
+
+                consecutiveFailedSearchPaths += Params.RoomBatchSize * FMath::Max(Params.NumCandidateRays, 1);
+                if (consecutiveFailedSearchPaths >= MaxConsecutiveFailedSearchPaths)
+                {
+                    UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder gave up after %i search paths in a row found no space. Placed %i of %i rooms"),
+                        consecutiveFailedSearchPaths, Layout->Rooms.Num(), Params.NumberOfRooms);
+                    break;
+                }
+
+                continue; // try again
+            }
+
+            consecutiveFailedSearchPaths = 0;
+            numToSpawn -= numPlaced;
+            continue;
+        }
+
+        if (Params.PlacementStrategy == ELabyrinthPlacementStrategy::Bitboard ||
+            Params.PlacementStrategy == ELabyrinthPlacementStrategy::EmptySquares)
+        {
+            bool found{ Params.PlacementStrategy == ELabyrinthPlacementStrategy::Bitboard ?
+                FindRoomCellWithBitboard(direction, potentialRoomCoordinates) :
+                FindRoomCellInEmptySquares(potentialRoomCoordinates) };
+
+            if (!found)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder ran out of space after %i of %i rooms"), Layout->Rooms.Num(), Params.NumberOfRooms);
+                break;
+            }
+        }
+        else if (Params.NumCandidateRays > 1)
+        {
+            // The first direction is drawn above, so one candidate walks the same path single ray placement would.
+            CandidateDirections.Reset();
+            CandidateDirections.Add(direction);
+            for (int32 candidate = 1; candidate < Params.NumCandidateRays; candidate++)
+            {
+                CandidateDirections.Emplace(RandomStream.FRandRange(-1.0, 1.0), RandomStream.FRandRange(-1.0, 1.0));
+            }
+
+            if (!FindRoomCellAlongSearchPaths(CandidateDirections, potentialRoomCoordinates))
+            {
+                UE_LOG(LogTemp, Log, TEXT("LabyrinthBuilder could not spawn a room along %i search paths! Trying new paths."), CandidateDirections.Num());
+
+                consecutiveFailedSearchPaths += CandidateDirections.Num();
+                if (consecutiveFailedSearchPaths >= MaxConsecutiveFailedSearchPaths)
+                {
+                    UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder gave up after %i search paths in a row found no space. Placed %i of %i rooms"),
+                        consecutiveFailedSearchPaths, Layout->Rooms.Num(), Params.NumberOfRooms);
+                    break;
+                }
+
+                continue; // try again
+            }
+        }
+        else if (!FindRoomCellAlongSearchPath(direction, potentialRoomCoordinates))
+        {
+            UE_LOG(LogTemp, Log, TEXT("LabyrinthBuilder could not spawn a room along a search path! Trying a new path."));
+
+            if (++consecutiveFailedSearchPaths >= MaxConsecutiveFailedSearchPaths)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder gave up after %i search paths in a row found no space. Placed %i of %i rooms"),
+                    consecutiveFailedSearchPaths, Layout->Rooms.Num(), Params.NumberOfRooms);
+                break;
+            }
+
+            continue; // try again
+        }
+
+        consecutiveFailedSearchPaths = 0;
+
+        numToSpawn--;
+
+        PlaceRoom(potentialRoomCoordinates);
+
+        ConnectRoom(potentialRoomCoordinates);
+
+        AddRoomDoorsToDistanceField(potentialRoomCoordinates);
+
+        // Update distance field
+        RecalculateDistanceField();
+    }
+}
+
+bool FLabyrinthLayoutGenerator::FindRoomCellAlongSearchPath(FVector2D direction, FIntVector2& outCell)
+{
+    // Nothing is stamped while searching, so one update covers the whole search.
+    BlockedArea.Update(DistanceField.GetBlockedPlane());
+
+    int32 steps{ 0 };
+    bool found{ WalkSearchPath(direction, outCell, steps) };
+
+    Stats.NumSearchPathSteps += steps;
+    INC_DWORD_STAT_BY(STAT_LabyrinthSearchPathSteps, steps);
+
+    if (!found)
+    {
+        Stats.NumFailedSearchPaths++;
+        INC_DWORD_STAT(STAT_LabyrinthFailedPlacements);
+    }
+
+    return found;
+}
+
+bool FLabyrinthLayoutGenerator::FindRoomCellAlongSearchPaths(TConstArrayView<FVector2D> directions, FIntVector2& outCell)
+{
+    WalkSearchPaths(directions);
+
+    int32 winner{ PickCandidate(0, directions.Num()) };
+    if (winner == INDEX_NONE)
+    {
+        return false;
+    }
+
+    outCell = CandidateResults[winner].Cell;
+    return true;
+}
+
+void FLabyrinthLayoutGenerator::WalkSearchPaths(TConstArrayView<FVector2D> directions)
+{
+    BlockedArea.Update(DistanceField.GetBlockedPlane());
+
+    CandidateResults.SetNum(directions.Num(), EAllowShrinking::No);
+
+    // Every walk only reads the blocked area, so they can all run at once.
+    ParallelFor(directions.Num(), [&](int32 candidate)
+    {
+        FSearchPathResult& result = CandidateResults[candidate];
+        result.Steps = 0;
+        result.bFound = WalkSearchPath(directions[candidate], result.Cell, result.Steps);
+    });
+
+    for (const FSearchPathResult& result : CandidateResults)
+    {
+        Stats.NumSearchPathSteps += result.Steps;
+        INC_DWORD_STAT_BY(STAT_LabyrinthSearchPathSteps, result.Steps);
+
+        if (!result.bFound)
+        {
+            Stats.NumFailedSearchPaths++;
+            INC_DWORD_STAT(STAT_LabyrinthFailedPlacements);
+        }
+    }
+}
+
+int32 FLabyrinthLayoutGenerator::PickCandidate(int32 firstCandidate, int32 numCandidates) const
+{
+    // The shortest successful walk wins, and the earliest drawn direction breaks ties, so the choice does not depend on
+    // which thread finished first.
+    int32 winner{ INDEX_NONE };
+    for (int32 candidate = firstCandidate; candidate < firstCandidate + numCandidates; candidate++)
+    {
+        const FSearchPathResult& result = CandidateResults[candidate];
+        if (result.bFound && (winner == INDEX_NONE || result.Steps < CandidateResults[winner].Steps))
+        {
+            winner = candidate;
+        }
+    }
+
+    return winner;
+}
+
+int32 FLabyrinthLayoutGenerator::PlaceRoomBatch(FVector2D firstDirection, int32 maxRooms)
+{
+    const int32 numProposals{ FMath::Min(Params.RoomBatchSize, maxRooms) };
+    const int32 numCandidateRays{ FMath::Max(Params.NumCandidateRays, 1) };
+
+    // Each proposal gets its own candidate rays, all drawn up front so the stream is consumed the same way every run.
+    CandidateDirections.Reset();
+    CandidateDirections.Add(firstDirection);
+    while (CandidateDirections.Num() < numProposals * numCandidateRays)
+    {
+        CandidateDirections.Emplace(RandomStream.FRandRange(-1.0, 1.0), RandomStream.FRandRange(-1.0, 1.0));
+    }
+
+    // Every proposal is found against the labyrinth as it was before the batch.
+    WalkSearchPaths(CandidateDirections);
+
+    // Accept proposals in the order they were drawn, skipping any that collide with one already accepted.
+    BatchRooms.Reset();
+    for (int32 proposal = 0; proposal < numProposals; proposal++)
+    {
+        int32 winner{ PickCandidate(proposal * numCandidateRays, numCandidateRays) };
+        if (winner == INDEX_NONE)
+        {
+            continue;
+        }
+
+        FIntVector2 roomCell{ CandidateResults[winner].Cell };
+        bool conflicts{ BatchRooms.ContainsByPredicate([&](FIntVector2 acceptedRoom) { return DoRoomsConflict(roomCell, acceptedRoom); }) };
+
+        if (!conflicts)
+        {
+            BatchRooms.Add(roomCell);
+        }
+    }
+
+    // Stamp every room first so no hallway is laid through a room of the same batch.
+    for (FIntVector2 roomCell : BatchRooms)
+    {
+        PlaceRoom(roomCell);
+    }
+
+    // Hallways walk the field from before the batch. They stop at any hall, including ones laid earlier in this batch.
+    for (FIntVector2 roomCell : BatchRooms)
+    {
+        ConnectRoom(roomCell);
+    }
+
+    for (FIntVector2 roomCell : BatchRooms)
+    {
+        AddRoomDoorsToDistanceField(roomCell);
+    }
+
+    if (BatchRooms.Num() > 0)
+    {
+        RecalculateDistanceField();
+    }
+
+    return BatchRooms.Num();
+}
+
+bool FLabyrinthLayoutGenerator::DoRoomsConflict(FIntVector2 roomCell, FIntVector2 otherRoomCell)
+{
+    auto isInRoom = [this](FIntVector2 cell, FIntVector2 room)
+    {
+        return
+            cell.X >= room.X && cell.X < room.X + Params.RoomCellSize.X &&
+            cell.Y >= room.Y && cell.Y < room.Y + Params.RoomCellSize.Y;
+    };
+
+    // Footprints overlap
+    if (FMath::Abs(roomCell.X - otherRoomCell.X) < Params.RoomCellSize.X &&
+        FMath::Abs(roomCell.Y - otherRoomCell.Y) < Params.RoomCellSize.Y)
+    {
+        return true;
+    }
+
+    // Placed one after the other, the second room could not have covered the first room's doors.
+    for (const FTransform& door : Params.RoomDoors)
+    {
+        if (isInRoom(FindDoorCoordinate(roomCell, door), otherRoomCell) ||
+            isInRoom(FindDoorCoordinate(otherRoomCell, door), roomCell))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FLabyrinthLayoutGenerator::WalkSearchPath(FVector2D direction, FIntVector2& outCell, int32& outSteps) const
+{
+    // Find an open space.
+    // Start at center and move in the chosen direction looking for enough space for the new room.
+    FIntVector2 center{ Params.Dimensions.X / 2, Params.Dimensions.Y / 2 };
+
+    int roomsizeX = Params.RoomCellSize.X;
+    int roomsizeY = Params.RoomCellSize.Y;
+
+    FLabyrinthGridRay searchPath{ center, direction };
+
+    // Search for open space along the search path until:
+    // 1. we find open space or
+    // 2. we hit the edge.
+    while (AreRoomExtentsWithinLabyrinth(searchPath.GetCell(), roomsizeX, roomsizeY))
+    {
+        // No blocked cells under the footprint, so we have found our spawn position
+        if (BlockedArea.CountInRect(searchPath.GetCell(), Params.RoomCellSize) == 0)
+        {
+            outCell = searchPath.GetCell();
+            return true;
+        }
+
+        // otherwise there is overlap, move on to the next cell along the path and continue
+        searchPath.Step();
+        outSteps++;
+    }
+
+    return false;
+}
+
+bool FLabyrinthLayoutGenerator::FindRoomCellWithBitboard(FVector2D direction, FIntVector2& outCell)
+{
+    // Aim at a random point along the ray rather than its first free cell, then take the free spot nearest to it.
+    // Rooms still spread out around the center but pack tightly wherever they land.
+    FVector2D halfDimensions{ Params.Dimensions.X * 0.5, Params.Dimensions.Y * 0.5 };
+    FVector2D targetPosition{ halfDimensions + (direction * halfDimensions * RandomStream.FRand()) };
+
+    FIntVector2 target{
+        FMath::FloorToInt32(targetPosition.X) - (Params.RoomCellSize.X / 2),
+        FMath::FloorToInt32(targetPosition.Y) - (Params.RoomCellSize.Y / 2) };
+
+    // One row and column of margin, as the search rays keep.
+    return BitboardPlacer.FindNearestFit(DistanceField.GetBlockedPlane(), Params.RoomCellSize, target, outCell, 1);
+}
+
+bool FLabyrinthLayoutGenerator::FindRoomCellInEmptySquares(FIntVector2& outCell)
+{
+    EmptySquares.Update(DistanceField.GetBlockedPlane());
+
+    if (!EmptySquares.HasValidAnchor())
+    {
+        return false;
+    }
+
+    outCell = EmptySquares.GetValidAnchor(RandomStream.RandRange(0, EmptySquares.GetNumValidAnchors() - 1));
+    return true;
+}
+
+void FLabyrinthLayoutGenerator::PlaceFirstRoom()
+{
+    FIntVector2 roomSpawnCell
+    {
+        (Params.Dimensions.X / 2) - (Params.RoomCellSize.X / 2),
+        (Params.Dimensions.Y / 2) - (Params.RoomCellSize.Y / 2)
+    };
+
+    PlaceRoom(roomSpawnCell);
+
+    AddRoomDoorsToDistanceField(roomSpawnCell);
+}
+
+/// <summary>
+/// Place a room at the given location, which is the x, y minimum extent of the room.
+/// </summary>
+/// <param name="cell"></param>
+void FLabyrinthLayoutGenerator::PlaceRoom(FIntVector2 cell)
+{
+    Layout->Rooms.Add(cell);
+
+    AddRoomToDistanceField(cell);
+}
+
+void FLabyrinthLayoutGenerator::AddRoomToDistanceField(FIntVector2 cell)
+{
+    MarkPlacementDirty(cell, Params.RoomCellSize);
+
+    // Room tiles are not passable.
+    for (int y = 0; y < Params.RoomCellSize.Y; y++)
+    {
+        for (int x = 0; x < Params.RoomCellSize.X; x++)
+        {
+            DistanceField.SetRoom(cell + FIntVector2{ x, y });
+        }
+    }
+}
+
+void FLabyrinthLayoutGenerator::AddRoomDoorsToDistanceField(FIntVector2 cell)
+{
+    // Mark the space outside each door as a potential door.
+    for (const FTransform& door : Params.RoomDoors)
+    {
+        FIntVector2 doorCoordinate{ FindDoorCoordinate(cell, door) };
+
+        // Make sure we are still in the array and not overriding a room
+        if (!IsInDistanceField(doorCoordinate) || DistanceField.IsRoom(doorCoordinate))
+        {
+            continue;
+        }
+
+        // Make that coordinate 0 in the distance field
+        SetPotentialDoorCell(doorCoordinate);
+    }
+}
+
+FIntVector2 FLabyrinthLayoutGenerator::FindDoorCoordinate(FIntVector2 roomCell, const FTransform& door)
+{
+    // Move door position forward into an adjoining cell.
+        // The provided position is the door prefab spawn position.
+        // The forward direction of the provided transform indicates "out of the room"
+        // Adding half of a unit also accounts for float precision.
+    FVector doorPosition = door.GetLocation();
+    FVector hallPosition = FVector{ doorPosition.X, doorPosition.Y, doorPosition.Z };
+    FVector doorForward3{ door.GetRotation().GetForwardVector() };
+    FVector2D doorForward{ doorForward3.X, doorForward3.Y };
+    hallPosition = hallPosition + ((FVector{ doorForward.X, doorForward.Y, 0 } * Params.CellUnit * 0.5f));
+
+    // Translate to coordinate in grid
+    int doorX{ roomCell.X + Converter.MetersToCellFloor(hallPosition.X) };
+
+    int doorY{ roomCell.Y + Converter.MetersToCellFloor(hallPosition.Y) };
+
+    return FIntVector2{ doorX, doorY };
+}
+
+bool FLabyrinthLayoutGenerator::IsInDistanceField(FIntVector2 cell) const
+{
+    return DistanceField.IsInBounds(cell);
+}
+
+bool FLabyrinthLayoutGenerator::AreRoomExtentsWithinLabyrinth(FIntVector2 position, int sizeX, int sizeY) const
+{
+    return
+        IsInDistanceField(position + FIntVector2{ 0, sizeY }) &&
+        IsInDistanceField(position) &&
+        IsInDistanceField(position + FIntVector2{ sizeX, 0 }) &&
+        IsInDistanceField(position + FIntVector2{ sizeX, sizeY });
+}
+
+void FLabyrinthLayoutGenerator::MarkPlacementDirty(FIntVector2 cell, FIntVector2 size)
+{
+    if (Params.PlacementStrategy == ELabyrinthPlacementStrategy::SearchRays)
+    {
+        BlockedArea.MarkDirty(cell);
+    }
+    else if (Params.PlacementStrategy == ELabyrinthPlacementStrategy::EmptySquares)
+    {
+        EmptySquares.MarkDirty(cell, size);
+    }
+}
+
+void FLabyrinthLayoutGenerator::SetPotentialDoorCell(FIntVector2 cell)
+{
+    // If cell not found in zeroDistanceCoordinates cache
+    if (!ZeroDistanceMembership.TestAndSet(cell))
+    {
+        DistanceField.SetPotentialDoor(cell);
+        MarkPlacementDirty(cell);
+
+        ZeroDistanceCoordinates.Add(cell);
+    }
+}
+
+void FLabyrinthLayoutGenerator::SetHallwayCell(FIntVector2 cell)
+{
+    // hall overrides potential door. Always set this.
+    DistanceField.SetHall(cell);
+    MarkPlacementDirty(cell);
+
+    if (!ZeroDistanceMembership.TestAndSet(cell))
+    {
+        ZeroDistanceCoordinates.Add(cell);
+    }
+}
+
+void FLabyrinthLayoutGenerator::ConnectRoom(FIntVector2 roomCell)
+{
+    if (ConnectToExistingRooms(roomCell))
+    {
+        return;
+    }
+
+    // Flood in everything added since the last update, which is usually what the walk was missing, and try once more.
+    RecalculateDistanceField();
+
+    if (ConnectToExistingRooms(roomCell))
+    {
+        return;
+    }
+
+    // Rooms stamped since the last flood can cut off paths the field still counts, and distances never grow back.
+    // Flooding from scratch leaves no stale distance for the walk to follow.
+    RecalculateDistanceField(true);
+
+    if (!ConnectToExistingRooms(roomCell))
+    {
+        Stats.NumUnconnectedRooms++;
+        UE_LOG(LogTemp, Warning, TEXT("LabyrinthBuilder could not find a way downhill from the room at %i, %i. It is left unconnected."),
+            roomCell.X, roomCell.Y);
+    }
+}
+
+bool FLabyrinthLayoutGenerator::ConnectToExistingRooms(FIntVector2 roomSpawnCoordinate)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(Labyrinth_ConnectToExistingRooms);
+    SCOPE_CYCLE_COUNTER(STAT_LabyrinthConnectRooms);
+    FScopedDurationTimer corridorTimer{ Stats.CorridorSeconds };
+
+    if (Params.RoomDoors.IsEmpty()) { return true; }
+
+    FIntVector2 minimumDistanceDoor{};
+
+    // Doors inside a room or that the field has not reached have nowhere to walk to, so they are never picked.
+    int currentMinimumDistance{ FLabyrinthDistanceField::PathCostUnreached };
+
+    // pick a door to connect based on minimum distance in distance field
+    for (const FTransform& door : Params.RoomDoors)
+    {
+        FIntVector2 doorCoordinates = FindDoorCoordinate(roomSpawnCoordinate, door);
+        if (!IsInDistanceField(doorCoordinates))
+        {
+            continue;
+        }
+
+        int currentDistance{ DistanceField.GetPathCost(doorCoordinates) };
+
+        if (currentDistance < currentMinimumDistance)
+        {
+            currentMinimumDistance = currentDistance;
+            minimumDistanceDoor = doorCoordinates;
+        }
+    }
+
+    if (currentMinimumDistance == FLabyrinthDistanceField::PathCostUnreached)
+    {
+        return false;
+    }
+
+    FIntVector2 currentPathLocation = minimumDistanceDoor;
+
+    ScratchArena.ResetPath();
+    ScratchArena.AddToPath(currentPathLocation);
+
+    while (DistanceField.GetPathCost(currentPathLocation) > 0)
+    {
+        // look in all directions for minimum distance. set that as new current location.
+        FIntVector2 minimumDistanceCell{};
+        int currentMinimumCellDistance{ std::numeric_limits<int>::max() };
+
+        for (FIntVector2 direction : TraversalDirections)
+        {
+            FIntVector2 cellCoord{ currentPathLocation + direction };
+            if (!IsInDistanceField(cellCoord))
+            {
+                continue;
+            }
+
+            int cellValue{ DistanceField.GetPathCost(cellCoord) };
+
+            if (cellValue < currentMinimumCellDistance)
+            {
+                currentMinimumCellDistance = cellValue;
+                minimumDistanceCell = cellCoord;
+            }
+        }
+
+        // Every neighbor is at least as far, so the field is stale here and walking on could go round in circles.
+        if (currentMinimumCellDistance >= DistanceField.GetPathCost(currentPathLocation))
+        {
+            return false;
+        }
+
+        currentPathLocation = minimumDistanceCell;
+        ScratchArena.AddToPath(currentPathLocation);
+    }
+
+    for (FIntVector2 cell : ScratchArena.GetPath())
+    {
+        if (!DistanceField.IsHall(cell))
+        {
+            Layout->HallCells.Add(cell);
+
+            SetHallwayCell(cell);
+        }
+    }
+
+    return true;
+}
+
+void FLabyrinthLayoutGenerator::RecalculateDistanceField(bool bFromScratch)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(Labyrinth_RecalculateDistanceField);
+    SCOPE_CYCLE_COUNTER(STAT_LabyrinthDistanceField);
+    FScopedDurationTimer distanceFieldTimer{ Stats.DistanceFieldSeconds };
+
+    // Check zero distance coordinates for recalculation of neighbors.
+    // Distances only ever shrink, so the field is already settled around cells that seeded a previous pass.
+    // Seeding from just the new cells gives the same result as seeding from all of them.
+    int firstSeedIndex{ Params.bIncrementalDistanceField ? NextDistanceFieldSeedIndex : 0 };
+
+    if (bFromScratch)
+    {
+        DistanceField.ResetDistances();
+        firstSeedIndex = 0;
+    }
+
+    TConstArrayView<FIntVector2> seeds{ TConstArrayView<FIntVector2>(ZeroDistanceCoordinates).RightChop(firstSeedIndex) };
+
+    int32 numVisited{ 0 };
+    if (Params.ParallelDistanceFieldMinCells > 0 && DistanceField.Num() >= Params.ParallelDistanceFieldMinCells)
+    {
+        numVisited = DistanceField.Flood(seeds, ScratchArena.GetParallelFlood());
+    }
+    else if (Params.bWavefrontDistanceField)
+    {
+        numVisited = DistanceField.Flood(seeds, ScratchArena.GetWavefront());
+    }
+    else
+    {
+        numVisited = DistanceField.Flood(seeds, ScratchArena.GetFrontier());
+    }
+
+    Stats.NumCellsVisited += numVisited;
+    INC_DWORD_STAT_BY(STAT_LabyrinthCellsVisited, numVisited);
+
+    NextDistanceFieldSeedIndex = ZeroDistanceCoordinates.Num();
+}
+
+void FLabyrinthLayoutGenerator::FindDoorStates()
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(Labyrinth_FindDoorStates);
+    SCOPE_CYCLE_COUNTER(STAT_LabyrinthDoorStates);
+
+    Layout->OpenDoors.Init(false, Layout->Rooms.Num() * Params.RoomDoors.Num());
+
+    int doorBit{ 0 };
+    for (FIntVector2 roomCell : Layout->Rooms)
+    {
+        for (const FTransform& door : Params.RoomDoors)
+        {
+            FIntVector2 doorCoordinate{ FindDoorCoordinate(roomCell, door) };
+
+            if (IsInDistanceField(doorCoordinate) && DistanceField.IsHall(doorCoordinate))
+            {
+                Layout->OpenDoors[doorBit] = true;
+            }
+
+            doorBit++;
+        }
+    }
+}
+
+void FLabyrinthLayoutGenerator::FindHallwayWalls()
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(Labyrinth_FindHallwayWalls);
+    SCOPE_CYCLE_COUNTER(STAT_LabyrinthHallwayWalls);
+
+    // Test a whole word of hall cells against their neighbors at once, then record a wall for each set bit.
+    const int wordsPerRow{ DistanceField.GetWordsPerRow() };
+
+    for (int y = 0; y < Params.Dimensions.Y; y++)
+    {
+        for (int wordIndex = 0; wordIndex < wordsPerRow; wordIndex++)
+        {
+            for (FIntVector2 direction : TraversalDirections)
+            {
+                uint64 wallMask{ DistanceField.GetHallWallWord(y, wordIndex, direction) };
+
+                if (Params.bMergeHallwayWalls)
+                {
+                    Layout->NumWallFaces += FMath::CountBits(wallMask);
+                    continue;
+                }
+
+                while (wallMask != 0)
+                {
+                    int bit{ static_cast<int>(FMath::CountTrailingZeros64(wallMask)) };
+                    wallMask &= wallMask - 1;
+
+                    FIntVector2 hallCell{ (wordIndex * FLabyrinthBitPlane::BitsPerWord) + bit, y };
+                    Layout->WallRuns.Add(FLabyrinthWallRun{ hallCell, hallCell, direction });
+                    Layout->NumWallFaces++;
+                }
+            }
+        }
+    }
+
+    if (Params.bMergeHallwayWalls)
+    {
+        FindMergedHallwayWalls();
+        UE_LOG(LogTemp, Log, TEXT("LabyrinthBuilder merged %i hallway wall faces into %i wall pieces"), Layout->NumWallFaces, Layout->WallRuns.Num());
+    }
+}
+
+void FLabyrinthLayoutGenerator::FindMergedHallwayWalls()
+{
+    const int wordsPerRow{ DistanceField.GetWordsPerRow() };
+
+    // Walls facing +-Y run along a row. Consecutive bits in the row's wall masks form one run.
+    for (FIntVector2 direction : TraversalDirections)
+    {
+        if (direction.Y == 0) { continue; }
+
+        for (int y = 0; y < Params.Dimensions.Y; y++)
+        {
+            int runStartX{ -1 };
+            int previousX{ -1 };
+
+            for (int wordIndex = 0; wordIndex < wordsPerRow; wordIndex++)
+            {
+                uint64 wallMask{ DistanceField.GetHallWallWord(y, wordIndex, direction) };
+
+                while (wallMask != 0)
+                {
+                    int x{ (wordIndex * FLabyrinthBitPlane::BitsPerWord) + static_cast<int>(FMath::CountTrailingZeros64(wallMask)) };
+                    wallMask &= wallMask - 1;
+
+                    if (runStartX >= 0 && x != previousX + 1)
+                    {
+                        Layout->WallRuns.Add(FLabyrinthWallRun{ FIntVector2{ runStartX, y }, FIntVector2{ previousX, y }, direction });
+                        runStartX = -1;
+                    }
+
+                    if (runStartX < 0) { runStartX = x; }
+                    previousX = x;
+                }
+            }
+
+            if (runStartX >= 0)
+            {
+                Layout->WallRuns.Add(FLabyrinthWallRun{ FIntVector2{ runStartX, y }, FIntVector2{ previousX, y }, direction });
+            }
+        }
+    }
+
+    // Walls facing +-X run along a column. Compare each row's mask with the runs still open from the rows above:
+    // bits that drop out end a run, new bits start one.
+    TArray<uint64> openRuns;
+    TArray<int> runStartY;
+
+    for (FIntVector2 direction : TraversalDirections)
+    {
+        if (direction.X == 0) { continue; }
+
+        openRuns.Init(0, wordsPerRow);
+        runStartY.Init(-1, wordsPerRow * FLabyrinthBitPlane::BitsPerWord);
+
+        for (int y = 0; y <= Params.Dimensions.Y; y++)
+        {
+            for (int wordIndex = 0; wordIndex < wordsPerRow; wordIndex++)
+            {
+                uint64 wallMask{ y < Params.Dimensions.Y ? DistanceField.GetHallWallWord(y, wordIndex, direction) : 0 };
+
+                uint64 endedRuns{ openRuns[wordIndex] & ~wallMask };
+                while (endedRuns != 0)
+                {
+                    int x{ (wordIndex * FLabyrinthBitPlane::BitsPerWord) + static_cast<int>(FMath::CountTrailingZeros64(endedRuns)) };
+                    endedRuns &= endedRuns - 1;
+
+                    Layout->WallRuns.Add(FLabyrinthWallRun{ FIntVector2{ x, runStartY[x] }, FIntVector2{ x, y - 1 }, direction });
+                }
+
+                uint64 startedRuns{ wallMask & ~openRuns[wordIndex] };
+                while (startedRuns != 0)
+                {
+                    int x{ (wordIndex * FLabyrinthBitPlane::BitsPerWord) + static_cast<int>(FMath::CountTrailingZeros64(startedRuns)) };
+                    startedRuns &= startedRuns - 1;
+
+                    runStartY[x] = y;
+                }
+
+                openRuns[wordIndex] = wallMask;
+            }
+        }
+    }
+}
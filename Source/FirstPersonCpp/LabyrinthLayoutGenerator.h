@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <atomic>
+
+#include "CoreMinimal.h"
+
+#include "CellUnitConverter.h"
+#include "LabyrinthBitboardPlacer.h"
+#include "LabyrinthBitPlane.h"
+#include "LabyrinthDistanceField.h"
+#include "LabyrinthEmptySquareMap.h"
+#include "LabyrinthLayout.h"
+#include "LabyrinthScratchArena.h"
+#include "LabyrinthSummedAreaTable.h"
+
+/**
+ * Where the time of one Generate call went, and what it needed.
+ */
+struct FLabyrinthGenerationStats
+{
+	// Picking room positions, excluding the distance field and corridor time spent in between.
+	double RoomPlacementSeconds = 0.0;
+	double DistanceFieldSeconds = 0.0;
+	double CorridorSeconds = 0.0;
+	double DoorSeconds = 0.0;
+	double WallSeconds = 0.0;
+	double TotalSeconds = 0.0;
+
+	// Search paths that hit the labyrinth edge without finding space for a room
+	int32 NumFailedSearchPaths = 0;
+
+	// Cells stepped over along room search paths
+	int32 NumSearchPathSteps = 0;
+
+	// Cells taken off the distance field frontier, over every update
+	int64 NumCellsVisited = 0;
+
+	// Rooms with no door that could reach a hall, even on a freshly flooded distance field
+	int32 NumUnconnectedRooms = 0;
+
+	// Times the scratch buffers had to grow
+	int32 NumScratchAllocations = 0;
+
+	// Bytes held by the generator's grids and scratch buffers
+	SIZE_T AllocatedBytes = 0;
+};
+
+/**
+ * Generates labyrinth layouts as plain data. Does not touch the world, so it can run anywhere.
+ * Keep one generator around between builds so its scratch buffers are reused.
+ */
+class FIRSTPERSONCPP_API FLabyrinthLayoutGenerator
+{
+public:
+	// Generate a layout for the given parameters into outLayout.
+	// Returns false if the parameters cannot produce one, or if cancelRequested is set while generating.
+	bool Generate(const FLabyrinthLayoutParams& params, FLabyrinthLayout& outLayout, const std::atomic<bool>* cancelRequested = nullptr);
+
+	// Distance field of the most recent layout
+	const FLabyrinthDistanceField& GetDistanceField() const { return DistanceField; }
+
+	// Rooms with no door that could reach a hall, even on a freshly flooded distance field
+	int32 NumUnconnectedRooms = 0;
+
+	// Times the scratch buffers had to grow during the most recent layout
+	int32 GetNumScratchAllocations() const { return ScratchArena.GetNumAllocations(); }
+
+	// Timings and sizes of the most recent layout
+	const FLabyrinthGenerationStats& GetStats() const { return Stats; }
+
+private:
+	bool IsCancelRequested() const { return CancelRequested && CancelRequested->load(std::memory_order_relaxed); }
+
+	void PlaceRooms();
+	void PlaceFirstRoom();
+
+	// Find where the next room goes, given a random direction out from the center.
+	bool FindRoomCellAlongSearchPath(FVector2D direction, FIntVector2& outCell);
+	bool FindRoomCellAlongSearchPaths(TConstArrayView<FVector2D> directions, FIntVector2& outCell);
+
+	// Walk every direction at once into CandidateResults, then pick the shortest successful walk in a range of them.
+	void WalkSearchPaths(TConstArrayView<FVector2D> directions);
+	int32 PickCandidate(int32 firstCandidate, int32 numCandidates) const;
+
+	// Propose up to maxRooms rooms at once and place those that do not conflict. Returns how many were placed.
+	int32 PlaceRoomBatch(FVector2D firstDirection, int32 maxRooms);
+	bool  DoRoomsConflict(FIntVector2 roomCell, FIntVector2 otherRoomCell);
+	bool FindRoomCellWithBitboard(FVector2D direction, FIntVector2& outCell);
+	bool FindRoomCellInEmptySquares(FIntVector2& outCell);
+
+	void PlaceRoom(FIntVector2 cell);
+
+	void AddRoomToDistanceField(FIntVector2 cell);
+	void AddRoomDoorsToDistanceField(FIntVector2 cell);
+
+	FIntVector2 FindDoorCoordinate(FIntVector2 roomCell, const FTransform& door);
+	bool        IsInDistanceField(FIntVector2 cell) const;
+	bool        AreRoomExtentsWithinLabyrinth(FIntVector2 position, int sizeX, int sizeY) const;
+
+	// Walk a search path out from the center against the current blocked area, which must be up to date.
+	// Only reads generator state, so several paths can be walked at once.
+	bool WalkSearchPath(FVector2D direction, FIntVector2& outCell, int32& outSteps) const;
+
+	// Note blocked cells changed for whichever placement structure the strategy keeps up to date.
+	void MarkPlacementDirty(FIntVector2 cell, FIntVector2 size = FIntVector2{ 1, 1 });
+
+	void SetPotentialDoorCell(FIntVector2 cell);
+	void SetHallwayCell(FIntVector2 cell);
+
+	// Lay a hallway from the room downhill to the nearest hall or door.
+	// Returns false without laying anything if the walk stalls on a distance field that is out of date.
+	bool ConnectToExistingRooms(FIntVector2 roomSpawnCoordinate);
+
+	// ConnectToExistingRooms, flooding the distance field and trying again if the walk stalls.
+	// Floods from scratch before giving up, and counts the room in NumUnconnectedRooms if it still stalls.
+	void ConnectRoom(FIntVector2 roomCell);
+
+	// Flood from the zero distance cells not yet seeded, or reset every distance and flood from all of them.
+	void RecalculateDistanceField(bool bFromScratch = false);
+
+	void FindDoorStates();
+
+	void FindHallwayWalls();
+	void FindMergedHallwayWalls();
+
+	FLabyrinthLayoutParams Params;
+
+	// Layout being generated
+	FLabyrinthLayout* Layout = nullptr;
+
+	const std::atomic<bool>* CancelRequested = nullptr;
+
+	CellUnitConverter Converter = CellUnitConverter(2.0);
+
+	// Zero distance cells in the order they were added. Iterated to keep generation deterministic.
+	TArray<FIntVector2> ZeroDistanceCoordinates;
+
+	// Grid-aligned membership for ZeroDistanceCoordinates so lookups do not scan the list.
+	FLabyrinthBitPlane ZeroDistanceMembership;
+
+	// Entries of ZeroDistanceCoordinates before this index have already seeded the distance field.
+	int NextDistanceFieldSeedIndex = 0;
+
+	FLabyrinthDistanceField DistanceField;
+
+	// Blocked cell counts over the distance field, so a room footprint is checked for overlap in constant time.
+	// Only kept up to date for ELabyrinthPlacementStrategy::SearchRays.
+	FLabyrinthSummedAreaTable BlockedArea;
+
+	// Row-at-a-time fit tests for ELabyrinthPlacementStrategy::Bitboard
+	FLabyrinthBitboardPlacer BitboardPlacer;
+
+	// One entry per candidate search path when several are walked at once
+	struct FSearchPathResult
+	{
+		FIntVector2 Cell{ 0, 0 };
+		int32 Steps = 0;
+		bool bFound = false;
+	};
+	TArray<FVector2D> CandidateDirections;
+	TArray<FSearchPathResult> CandidateResults;
+
+	// Rooms accepted from the current batch
+	TArray<FIntVector2> BatchRooms;
+
+	// Every position a room fits, for ELabyrinthPlacementStrategy::EmptySquares
+	FLabyrinthEmptySquareMap EmptySquares;
+
+	TArray<FIntVector2> TraversalDirections{ {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+
+	FRandomStream RandomStream;
+
+	// Scratch buffers for the hot loops. Kept across builds so rebuilding does not allocate.
+	FLabyrinthScratchArena ScratchArena;
+
+	FLabyrinthGenerationStats Stats;
+};
@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthMaterializer.h"
+
+#include "Algo/StableSort.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/World.h"
+#include "Kismet/KismetMathLibrary.h"
+
+#include "LabyrinthStats.h"
+
+void FLabyrinthMaterializer::Begin(const FLabyrinthLayout& layout, const FLabyrinthMaterializerSettings& settings)
+{
+    Settings = settings;
+    Converter = CellUnitConverter(layout.CellUnit);
+
+    Pieces.Reset();
+    NextPiece = 0;
+    NumActorsSpawned = 0;
+    NumInstancesAdded = 0;
+    SET_DWORD_STAT(STAT_LabyrinthActorsSpawned, 0);
+    SET_DWORD_STAT(STAT_LabyrinthInstancesAdded, 0);
+    PendingHallFloorInstances.Reset();
+    PendingHallWallInstances.Reset();
+
+    SpawnedRooms.Reset();
+    SpawnedRooms.SetNum(layout.Rooms.Num());
+    RoomLocations.Reset();
+
+    FRotator ownerRotation{ Settings.Owner->GetActorRotation() };
+
+    for (int32 roomIndex = 0; roomIndex < layout.Rooms.Num(); roomIndex++)
+    {
+        RoomLocations.Add(CellLocation(layout.Rooms[roomIndex]));
+        AddPiece(ELabyrinthPieceType::Room, roomIndex, FTransform{ ownerRotation, RoomLocations.Last() });
+    }
+
+    for (FIntVector2 hallCell : layout.HallCells)
+    {
+        AddPiece(ELabyrinthPieceType::HallFloor, INDEX_NONE, FTransform{ ownerRotation, CellLocation(hallCell) });
+    }
+
+    for (int32 roomIndex = 0; roomIndex < layout.Rooms.Num(); roomIndex++)
+    {
+        for (int32 doorIndex = 0; doorIndex < layout.GetDoorsPerRoom(); doorIndex++)
+        {
+            ELabyrinthPieceType doorType{ layout.IsDoorOpen(roomIndex, doorIndex) ? ELabyrinthPieceType::OpenDoor : ELabyrinthPieceType::ClosedDoor };
+            AddPiece(doorType, roomIndex, layout.RoomDoors[doorIndex]);
+        }
+    }
+
+    for (const FLabyrinthWallRun& wallRun : layout.WallRuns)
+    {
+        AddPiece(ELabyrinthPieceType::HallWall, INDEX_NONE, HallwayWallRunTransform(wallRun));
+    }
+}
+
+void FLabyrinthMaterializer::SortByDistanceTo(FVector location)
+{
+    auto pieceDistance = [this, location](const FLabyrinthPiece& piece)
+    {
+        // Doors are placed relative to their room, so sort them by the room's position.
+        bool isDoor{ piece.Type == ELabyrinthPieceType::OpenDoor || piece.Type == ELabyrinthPieceType::ClosedDoor };
+        FVector pieceLocation{ isDoor ? RoomLocations[piece.RoomIndex] : piece.Transform.GetLocation() };
+        return FVector::DistSquared(location, pieceLocation);
+    };
+
+    TArrayView<FLabyrinthPiece> remaining = TArrayView<FLabyrinthPiece>(Pieces).RightChop(NextPiece);
+
+    // Room is the first piece type, so at equal distance a room sorts ahead of its doors.
+    Algo::StableSort(remaining, [&pieceDistance](const FLabyrinthPiece& a, const FLabyrinthPiece& b)
+    {
+        double distanceA{ pieceDistance(a) };
+        double distanceB{ pieceDistance(b) };
+        return distanceA < distanceB || (distanceA == distanceB && a.Type < b.Type);
+    });
+}
+
+void FLabyrinthMaterializer::SpawnAll()
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(Labyrinth_SpawnAll);
+
+    while (SpawnNext()) {}
+
+    FlushInstances();
+}
+
+bool FLabyrinthMaterializer::SpawnNext()
+{
+    if (IsFinished())
+    {
+        return false;
+    }
+
+    SpawnPiece(Pieces[NextPiece]);
+    NextPiece++;
+
+    return true;
+}
+
+void FLabyrinthMaterializer::FlushInstances()
+{
+    if (Settings.HallFloorInstances && !PendingHallFloorInstances.IsEmpty())
+    {
+        Settings.HallFloorInstances->AddInstances(PendingHallFloorInstances, false, false);
+    }
+
+    if (Settings.HallWallInstances && !PendingHallWallInstances.IsEmpty())
+    {
+        Settings.HallWallInstances->AddInstances(PendingHallWallInstances, false, false);
+    }
+
+    PendingHallFloorInstances.Reset();
+    PendingHallWallInstances.Reset();
+}
+
+void FLabyrinthMaterializer::AddPiece(ELabyrinthPieceType type, int32 roomIndex, const FTransform& transform)
+{
+    FLabyrinthPiece& piece = Pieces.AddDefaulted_GetRef();
+    piece.Type = type;
+    piece.RoomIndex = roomIndex;
+    piece.Transform = transform;
+}
+
+void FLabyrinthMaterializer::SpawnPiece(const FLabyrinthPiece& piece)
+{
+    SCOPE_CYCLE_COUNTER(STAT_LabyrinthSpawnPieces);
+
+    AActor* Owner = Settings.Owner;
+
+    switch (piece.Type)
+    {
+    case ELabyrinthPieceType::Room:
+        SpawnedRooms[piece.RoomIndex] = SpawnUClass(Settings.Room, piece.Transform, Owner);
+        break;
+
+    case ELabyrinthPieceType::OpenDoor:
+        SpawnUClass(Settings.DoorOpenBlueprint, piece.Transform, SpawnedRooms[piece.RoomIndex].Get());
+        break;
+
+    case ELabyrinthPieceType::ClosedDoor:
+        SpawnUClass(Settings.DoorClosedBlueprint, piece.Transform, SpawnedRooms[piece.RoomIndex].Get());
+        break;
+
+    case ELabyrinthPieceType::HallFloor:
+        if (Settings.HallFloorInstances)
+        {
+            PendingHallFloorInstances.Add(piece.Transform);
+            NumInstancesAdded++;
+            INC_DWORD_STAT(STAT_LabyrinthInstancesAdded);
+        }
+        else
+        {
+            SpawnUClass(Settings.HallFloorCeilingBlueprint, piece.Transform, Owner);
+        }
+        break;
+
+    case ELabyrinthPieceType::HallWall:
+        if (Settings.HallWallInstances)
+        {
+            PendingHallWallInstances.Add(piece.Transform);
+            NumInstancesAdded++;
+            INC_DWORD_STAT(STAT_LabyrinthInstancesAdded);
+        }
+        else
+        {
+            SpawnUClass(Settings.HallWallBlueprint, piece.Transform, Owner);
+        }
+        break;
+    }
+}
+
+AActor* FLabyrinthMaterializer::SpawnUClass(TSubclassOf<AActor> actor, const FTransform& transform, AActor* parent)
+{
+    AActor* Owner = Settings.Owner;
+
+    FActorSpawnParameters SpawnParameters{};
+    SpawnParameters.Owner = Owner;
+
+    if (actor)
+    {
+        // Spawned at the relative transform, which attaching with KeepRelativeTransform then keeps relative to the parent.
+        AActor* newActor = Owner->GetWorld()->SpawnActor<AActor>(actor, transform.GetLocation(), transform.Rotator(), SpawnParameters);
+        if (!newActor)
+        {
+            return nullptr;
+        }
+
+        newActor->AttachToActor(parent, FAttachmentTransformRules::KeepRelativeTransform);
+
+        if (!transform.GetScale3D().Equals(FVector::OneVector))
+        {
+            newActor->SetActorRelativeScale3D(transform.GetScale3D());
+        }
+
+        NumActorsSpawned++;
+        INC_DWORD_STAT(STAT_LabyrinthActorsSpawned);
+        return newActor;
+    }
+
+    return nullptr;
+}
+
+FVector FLabyrinthMaterializer::CellLocation(FIntVector2 cell) const
+{
+    return FVector{ Converter.CellToMeters(cell.X), Converter.CellToMeters(cell.Y), 0 };
+}
+
+FTransform FLabyrinthMaterializer::HallwayWallTransform(FIntVector2 hallwayCell, FIntVector2 wallDirection) const
+{
+    FRotator hallwayRotation{ UKismetMathLibrary::FindLookAtRotation(FVector{}, FVector(wallDirection.X, wallDirection.Y, 0)) };
+
+    // Offset in the wall's local space that lines the wall up with the cell edge it faces.
+    FVector localOffset{};
+
+    if (wallDirection.X == 0 && wallDirection.Y == 1)
+    {
+        localOffset = FVector{ 0, Converter.CellToMeters(-1), 0 };
+    }
+    else if (wallDirection.X == 0 && wallDirection.Y == -1)
+    {
+        localOffset = FVector{ Converter.CellToMeters(-1), 0, 0 };
+    }
+    else if (wallDirection.X == -1 && wallDirection.Y == 0)
+    {
+        localOffset = FVector{ Converter.CellToMeters(-1), Converter.CellToMeters(-1), 0 };
+    }
+    else if (wallDirection.X == 1 && wallDirection.Y == 0) {} // no op
+    else
+    {
+        UE_LOG(LogTemp, Log, TEXT("Error! Unexpected direction found in FLabyrinthMaterializer::HallwayWallTransform: %i, %i"), wallDirection.X, wallDirection.Y);
+    }
+
+    return FTransform{ hallwayRotation, CellLocation(hallwayCell) + hallwayRotation.RotateVector(localOffset) };
+}
+
+FTransform FLabyrinthMaterializer::HallwayWallRunTransform(const FLabyrinthWallRun& wallRun) const
+{
+    FTransform firstTransform{ HallwayWallTransform(wallRun.FirstCell, wallRun.Direction) };
+
+    if (wallRun.Length() == 1)
+    {
+        return firstTransform;
+    }
+
+    // The wall extends along its local Y axis from its origin.
+    // Anchor the run on whichever end cell puts the rest of the run on that side.
+    FVector wallLengthAxis{ firstTransform.GetRotation().GetRightVector() };
+    FVector runAxis{
+        static_cast<double>(wallRun.LastCell.X - wallRun.FirstCell.X),
+        static_cast<double>(wallRun.LastCell.Y - wallRun.FirstCell.Y),
+        0 };
+
+    FTransform wallTransform{ FVector::DotProduct(wallLengthAxis, runAxis) >= 0 ? firstTransform : HallwayWallTransform(wallRun.LastCell, wallRun.Direction) };
+    wallTransform.SetScale3D(FVector{ 1, static_cast<double>(wallRun.Length()), 1 });
+
+    return wallTransform;
+}
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "CellUnitConverter.h"
+#include "LabyrinthLayout.h"
+#include "Room.h"
+
+class UHierarchicalInstancedStaticMeshComponent;
+
+enum class ELabyrinthPieceType : uint8
+{
+	Room,
+	OpenDoor,
+	ClosedDoor,
+	HallFloor,
+	HallWall
+};
+
+/**
+ * One thing to put in the world for a layout.
+ */
+struct FLabyrinthPiece
+{
+	ELabyrinthPieceType Type = ELabyrinthPieceType::Room;
+
+	// Room the piece belongs to. Doors are attached to their room.
+	int32 RoomIndex = INDEX_NONE;
+
+	// Relative to the owner, or to the room for doors.
+	FTransform Transform;
+};
+
+/**
+ * What to spawn for each kind of piece, and where.
+ */
+struct FLabyrinthMaterializerSettings
+{
+	AActor* Owner = nullptr;
+
+	TSubclassOf<ARoom> Room;
+	TSubclassOf<AActor> DoorOpenBlueprint;
+	TSubclassOf<AActor> DoorClosedBlueprint;
+	TSubclassOf<AActor> HallFloorCeilingBlueprint;
+	TSubclassOf<AActor> HallWallBlueprint;
+
+	// When set, hall floors and walls become instances on these components instead of actors.
+	UHierarchicalInstancedStaticMeshComponent* HallFloorInstances = nullptr;
+	UHierarchicalInstancedStaticMeshComponent* HallWallInstances = nullptr;
+};
+
+/**
+ * Turns a labyrinth layout into actors and instances attached to an owner.
+ */
+class FIRSTPERSONCPP_API FLabyrinthMaterializer
+{
+public:
+	// Work out every piece for the layout. Nothing is spawned yet.
+	void Begin(const FLabyrinthLayout& layout, const FLabyrinthMaterializerSettings& settings);
+
+	// Reorder the pieces that have not been spawned yet so the ones nearest to location come first.
+	// location is in the owner's space. Rooms still spawn before their doors.
+	void SortByDistanceTo(FVector location);
+
+	// Spawn every remaining piece and flush instances.
+	void SpawnAll();
+
+	// Spawn the next piece. Returns false when there is nothing left to spawn.
+	bool SpawnNext();
+
+	// Add instances collected so far to their components.
+	void FlushInstances();
+
+	bool IsFinished() const { return NextPiece >= Pieces.Num(); }
+	int32 GetNumPieces() const { return Pieces.Num(); }
+	int32 GetNumSpawnedPieces() const { return NextPiece; }
+
+	// Fraction of pieces spawned so far, 1 when there is nothing to spawn.
+	float GetProgress() const { return Pieces.IsEmpty() ? 1.0f : static_cast<float>(NextPiece) / Pieces.Num(); }
+
+	int32 GetNumActorsSpawned() const { return NumActorsSpawned; }
+	int32 GetNumInstancesAdded() const { return NumInstancesAdded; }
+
+private:
+	void AddPiece(ELabyrinthPieceType type, int32 roomIndex, const FTransform& transform);
+	void SpawnPiece(const FLabyrinthPiece& piece);
+
+	AActor* SpawnUClass(TSubclassOf<AActor> actor, const FTransform& transform, AActor* parent);
+
+	FVector CellLocation(FIntVector2 cell) const;
+	FTransform HallwayWallTransform(FIntVector2 hallwayCell, FIntVector2 wallDirection) const;
+	FTransform HallwayWallRunTransform(const FLabyrinthWallRun& wallRun) const;
+
+	FLabyrinthMaterializerSettings Settings;
+
+	CellUnitConverter Converter = CellUnitConverter(2.0);
+
+	TArray<FLabyrinthPiece> Pieces;
+	int32 NextPiece = 0;
+
+	TArray<TWeakObjectPtr<AActor>> SpawnedRooms;
+
+	// Owner space location of each room
+	TArray<FVector> RoomLocations;
+
+	// Transforms collected while spawning and added to the instance components in one batch.
+	TArray<FTransform> PendingHallFloorInstances;
+	TArray<FTransform> PendingHallWallInstances;
+
+	int32 NumActorsSpawned = 0;
+	int32 NumInstancesAdded = 0;
+};
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthParallelFlood.h"
+
+#include <type_traits>
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    // Lower distance to value unless another task got there first. Returns true if this call lowered it.
+    template<typename DistanceType>
+    bool AtomicLower(DistanceType& distance, DistanceType value)
+    {
+        using SignedType = std::make_signed_t<DistanceType>;
+        volatile SignedType* target = reinterpret_cast<volatile SignedType*>(&distance);
+
+        SignedType current{ FPlatformAtomics::AtomicRead(target) };
+        while (static_cast<DistanceType>(current) > value)
+        {
+            SignedType previous{ FPlatformAtomics::InterlockedCompareExchange(target, static_cast<SignedType>(value), current) };
+            if (previous == current)
+            {
+                return true;
+            }
+
+            current = previous;
+        }
+
+        return false;
+    }
+}
+
+template<typename DistanceType>
+int32 FLabyrinthParallelFlood::Flood(TLabyrinthGrid<DistanceType>& distances, const FLabyrinthBitPlane& impassable, TConstArrayView<FIntVector2> seeds, bool& bOutSaturated)
+{
+    const int32 width{ distances.GetWidth() };
+    const int32 height{ distances.GetHeight() };
+
+    Frontier.Reset();
+    for (FIntVector2 seed : seeds)
+    {
+        Allocations.Add(Frontier, distances.ToIndex(seed));
+    }
+
+    int32 numVisited{ 0 };
+    DistanceType nextDistance{ static_cast<DistanceType>(seeds.IsEmpty() ? 1 : distances[seeds[0]] + 1) };
+    bOutSaturated = false;
+
+    while (Frontier.Num() > 0)
+    {
+        if (nextDistance == TNumericLimits<DistanceType>::Max())
+        {
+            bOutSaturated = true;
+            break;
+        }
+
+        numVisited += Frontier.Num();
+
+        const int32 numChunks{ FMath::DivideAndRoundUp(Frontier.Num(), ChunkSize) };
+        if (ChunkFrontiers.Num() < numChunks)
+        {
+            Allocations.SetNum(ChunkFrontiers, numChunks);
+        }
+
+        ParallelFor(numChunks, [&](int32 chunkIndex)
+        {
+            FChunkFrontier& nextFrontier = ChunkFrontiers[chunkIndex];
+            nextFrontier.Cells.Reset();
+
+            const int32 first{ chunkIndex * ChunkSize };
+            const int32 last{ FMath::Min(first + ChunkSize, Frontier.Num()) };
+
+            for (int32 frontierIndex = first; frontierIndex < last; frontierIndex++)
+            {
+                const int32 currentIndex{ Frontier[frontierIndex] };
+                const int32 x{ currentIndex % width };
+                const int32 y{ currentIndex / width };
+
+                // The bit plane is indexed by coordinates, so each neighbour is checked without dividing its index again.
+                const FIntVector2 neighbors[4]{ { x - 1, y }, { x + 1, y }, { x, y - 1 }, { x, y + 1 } };
+                const int32 neighborIndices[4]{ currentIndex - 1, currentIndex + 1, currentIndex - width, currentIndex + width };
+
+                for (int32 direction = 0; direction < 4; direction++)
+                {
+                    const FIntVector2 neighbor{ neighbors[direction] };
+                    if (neighbor.X < 0 || neighbor.Y < 0 || neighbor.X >= width || neighbor.Y >= height || impassable.Get(neighbor))
+                    {
+                        continue;
+                    }
+
+                    if (AtomicLower(distances[neighborIndices[direction]], nextDistance))
+                    {
+                        nextFrontier.Allocations.Add(nextFrontier.Cells, neighborIndices[direction]);
+                    }
+                }
+            }
+        }, numChunks == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+        Frontier.Reset();
+        for (int32 chunkIndex = 0; chunkIndex < numChunks; chunkIndex++)
+        {
+            Allocations.Append(Frontier, ChunkFrontiers[chunkIndex].Cells);
+        }
+
+        nextDistance++;
+    }
+
+    return numVisited;
+}
+
+template int32 FLabyrinthParallelFlood::Flood<uint16>(TLabyrinthGrid<uint16>&, const FLabyrinthBitPlane&, TConstArrayView<FIntVector2>, bool&);
+template int32 FLabyrinthParallelFlood::Flood<uint32>(TLabyrinthGrid<uint32>&, const FLabyrinthBitPlane&, TConstArrayView<FIntVector2>, bool&);
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthAllocationCounter.h"
+#include "LabyrinthBitPlane.h"
+#include "LabyrinthGrid.h"
+
+/**
+ * Level synchronous breadth first flood spread over the task graph, for labyrinths too large to flood on one thread.
+ * Each level's frontier is cut into chunks that expand in parallel. Distances are lowered with an atomic compare and
+ * swap, so exactly one chunk claims each improved cell and adds it to its own next frontier.
+ * Every cell in a level is lowered to the same value, so the distances match the queue flood exactly.
+ */
+class FLabyrinthParallelFlood
+{
+public:
+	// Flood distances outwards from the given seeds, which must all hold the same distance, never entering cells set in impassable.
+	// Only lowers distances. Returns the number of cells expanded, the same count the queue flood returns.
+	// Stops with bOutSaturated set instead of writing the largest value DistanceType holds, which means unreached.
+	template<typename DistanceType>
+	int32 Flood(TLabyrinthGrid<DistanceType>& distances, const FLabyrinthBitPlane& impassable, TConstArrayView<FIntVector2> seeds, bool& bOutSaturated);
+
+	// Times the buffers had to grow
+	int32 GetNumAllocations() const
+	{
+		int32 numAllocations{ Allocations.Num() };
+		for (const FChunkFrontier& chunkFrontier : ChunkFrontiers)
+		{
+			numAllocations += chunkFrontier.Allocations.Num();
+		}
+		return numAllocations;
+	}
+
+	void ResetAllocationCount()
+	{
+		Allocations.Reset();
+		for (FChunkFrontier& chunkFrontier : ChunkFrontiers)
+		{
+			chunkFrontier.Allocations.Reset();
+		}
+	}
+
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T size{ Frontier.GetAllocatedSize() + ChunkFrontiers.GetAllocatedSize() };
+		for (const FChunkFrontier& chunkFrontier : ChunkFrontiers)
+		{
+			size += chunkFrontier.Cells.GetAllocatedSize();
+		}
+		return size;
+	}
+
+private:
+	// Frontier cells expanded by one task. Large enough that scheduling stays cheap next to the work.
+	static constexpr int32 ChunkSize = 4096;
+
+	// Cell indices at the current level
+	TArray<int32> Frontier;
+
+	// Next level cells found by one chunk. Each task counts its own growth, so no counter is shared between threads.
+	struct FChunkFrontier
+	{
+		TArray<int32> Cells;
+		FLabyrinthAllocationCounter Allocations;
+	};
+
+	// Concatenated into Frontier once every chunk is done
+	TArray<FChunkFrontier> ChunkFrontiers;
+
+	FLabyrinthAllocationCounter Allocations;
+};
@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthPlacementStrategy.generated.h"
+
+// How the layout generator looks for space for each new room.
+UENUM(BlueprintType)
+enum class ELabyrinthPlacementStrategy : uint8
+{
+	// Walk a random ray out from the center until the room fits. Retries with a new ray when one reaches the edge.
+	SearchRays,
+	// Test whole rows of occupancy bits at once and take the free spot nearest a random point along a random ray.
+	// Packs rooms densely and knows when the labyrinth is full.
+	Bitboard,
+	// Keep the set of every position a room fits and pick one at random. Knows when the labyrinth is full.
+	EmptySquares
+};
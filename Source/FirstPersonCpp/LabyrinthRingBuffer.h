@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthAllocationCounter.h"
+
+/**
+ * FIFO queue over a single power-of-two sized buffer.
+ * Pushing and popping never allocate once the buffer is large enough. Growth is counted so callers can check for it.
+ */
+template<typename ElementType>
+class TLabyrinthRingBuffer
+{
+public:
+	TLabyrinthRingBuffer() = default;
+
+	// Make sure at least capacity elements fit without growing.
+	void Reserve(int32 capacity)
+	{
+		if (capacity > GetCapacity())
+		{
+			Grow(static_cast<int32>(FMath::RoundUpToPowerOfTwo(static_cast<uint32>(capacity))));
+		}
+	}
+
+	void Push(const ElementType& element)
+	{
+		if (Count == GetCapacity())
+		{
+			Grow(FMath::Max(GetCapacity() * 2, 16));
+		}
+
+		Elements[(Head + Count) & Mask] = element;
+		Count++;
+	}
+
+	bool Pop(ElementType& outElement)
+	{
+		if (Count == 0)
+		{
+			return false;
+		}
+
+		outElement = Elements[Head];
+		Head = (Head + 1) & Mask;
+		Count--;
+		return true;
+	}
+
+	// Drop every element but keep the buffer.
+	void Reset()
+	{
+		Head = 0;
+		Count = 0;
+	}
+
+	bool IsEmpty() const { return Count == 0; }
+	int32 Num() const { return Count; }
+	int32 GetCapacity() const { return Elements.Num(); }
+
+	// Number of times the buffer has been (re)allocated.
+	int32 GetNumAllocations() const { return Allocations.Num(); }
+	void ResetAllocationCount() { Allocations.Reset(); }
+
+	SIZE_T GetAllocatedSize() const { return Elements.GetAllocatedSize(); }
+
+private:
+	void Grow(int32 newCapacity)
+	{
+		TArray<ElementType> newElements;
+		Allocations.SetNumUninitialized(newElements, newCapacity);
+
+		// Unwrap the live elements to the front of the new buffer.
+		for (int32 i = 0; i < Count; i++)
+		{
+			newElements[i] = Elements[(Head + i) & Mask];
+		}
+
+		Elements = MoveTemp(newElements);
+		Head = 0;
+		Mask = newCapacity - 1;
+	}
+
+	TArray<ElementType> Elements;
+	int32 Head = 0;
+	int32 Count = 0;
+	int32 Mask = 0;
+	FLabyrinthAllocationCounter Allocations;
+};
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthAllocationCounter.h"
+
+#include "LabyrinthParallelFlood.h"
+#include "LabyrinthRingBuffer.h"
+#include "LabyrinthWavefront.h"
+
+/**
+ * Scratch buffers for labyrinth generation that persist between builds.
+ * Every time one of them has to grow the allocation counter goes up, so a rebuild with the same settings should count zero.
+ */
+class FLabyrinthScratchArena
+{
+public:
+	// Size the buffers for a labyrinth of the given dimensions.
+	void Prepare(FIntVector2 dimensions)
+	{
+		// A BFS frontier over the grid stays within a couple of wavefronts, which are bounded by the grid perimeter.
+		int32 perimeter = 2 * (FMath::Max(dimensions.X, 1) + FMath::Max(dimensions.Y, 1));
+		Frontier.Reserve(2 * perimeter);
+
+		// Hallways are walked downhill, so a path rarely gets longer than the grid is wide and tall.
+		PathAllocations.Reserve(Path, perimeter);
+	}
+
+	// Cell indices waiting to be expanded by the distance field flood.
+	TLabyrinthRingBuffer<int32>& GetFrontier() { return Frontier; }
+
+	// Word buffers for the bit-parallel distance field flood. Sized on first use.
+	FLabyrinthWavefront& GetWavefront() { return Wavefront; }
+
+	// Frontier buffers for the multithreaded distance field flood.
+	FLabyrinthParallelFlood& GetParallelFlood() { return ParallelFlood; }
+
+	void ResetPath() { Path.Reset(); }
+
+	void AddToPath(FIntVector2 cell) { PathAllocations.Add(Path, cell); }
+
+	TConstArrayView<FIntVector2> GetPath() const { return Path; }
+
+	int32 GetNumAllocations() const { return PathAllocations.Num() + Frontier.GetNumAllocations() + Wavefront.GetNumAllocations() + ParallelFlood.GetNumAllocations(); }
+
+	void ResetAllocationCount()
+	{
+		PathAllocations.Reset();
+		Frontier.ResetAllocationCount();
+		Wavefront.ResetAllocationCount();
+		ParallelFlood.ResetAllocationCount();
+	}
+
+	SIZE_T GetAllocatedSize() const { return Frontier.GetAllocatedSize() + Wavefront.GetAllocatedSize() + ParallelFlood.GetAllocatedSize() + Path.GetAllocatedSize(); }
+
+private:
+	TLabyrinthRingBuffer<int32> Frontier;
+	FLabyrinthWavefront Wavefront;
+	FLabyrinthParallelFlood ParallelFlood;
+	TArray<FIntVector2> Path;
+	FLabyrinthAllocationCounter PathAllocations;
+};
@@ -0,0 +1,16 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthStats.h"
+
+DEFINE_STAT(STAT_LabyrinthPlaceRooms);
+DEFINE_STAT(STAT_LabyrinthDistanceField);
+DEFINE_STAT(STAT_LabyrinthConnectRooms);
+DEFINE_STAT(STAT_LabyrinthDoorStates);
+DEFINE_STAT(STAT_LabyrinthHallwayWalls);
+DEFINE_STAT(STAT_LabyrinthSpawnPieces);
+
+DEFINE_STAT(STAT_LabyrinthCellsVisited);
+DEFINE_STAT(STAT_LabyrinthSearchPathSteps);
+DEFINE_STAT(STAT_LabyrinthFailedPlacements);
+DEFINE_STAT(STAT_LabyrinthActorsSpawned);
+DEFINE_STAT(STAT_LabyrinthInstancesAdded);
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+
+// "stat Labyrinth" in the console. Phases also show up as named events in Unreal Insights.
+DECLARE_STATS_GROUP(TEXT("Labyrinth"), STATGROUP_Labyrinth, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Place Rooms"), STAT_LabyrinthPlaceRooms, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Distance Field"), STAT_LabyrinthDistanceField, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Connect Rooms"), STAT_LabyrinthConnectRooms, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Door States"), STAT_LabyrinthDoorStates, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hallway Walls"), STAT_LabyrinthHallwayWalls, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Pieces"), STAT_LabyrinthSpawnPieces, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
+
+// Totals for the most recent build. Not cleared every frame so they stay readable after the build.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Distance Field Cells Visited"), STAT_LabyrinthCellsVisited, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Search Path Steps"), STAT_LabyrinthSearchPathSteps, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Failed Placement Attempts"), STAT_LabyrinthFailedPlacements, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Actors Spawned"), STAT_LabyrinthActorsSpawned, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Instances Added"), STAT_LabyrinthInstancesAdded, STATGROUP_Labyrinth, FIRSTPERSONCPP_API);
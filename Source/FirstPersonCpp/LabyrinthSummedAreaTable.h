@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthBitPlane.h"
+#include "LabyrinthGrid.h"
+
+/**
+ * Summed-area table over a bit plane, so the number of set cells in any rectangle is four lookups.
+ * Cells that change are marked dirty and Update recomputes only the part of the table they affect,
+ * which is everything at or beyond the lowest dirty x and y.
+ */
+class FLabyrinthSummedAreaTable
+{
+public:
+	void Init(FIntVector2 dimensions)
+	{
+		Dimensions = FIntVector2{ FMath::Max(dimensions.X, 0), FMath::Max(dimensions.Y, 0) };
+
+		// One extra row and column of zeros so rectangles touching the edge need no special case.
+		Sums.Init(FIntVector2{ Dimensions.X + 1, Dimensions.Y + 1 }, 0);
+		DirtyMin = CleanMarker();
+	}
+
+	// Note that a cell of the source plane changed. Its sums are stale until the next Update.
+	void MarkDirty(FIntVector2 cell)
+	{
+		DirtyMin.X = FMath::Min(DirtyMin.X, cell.X);
+		DirtyMin.Y = FMath::Min(DirtyMin.Y, cell.Y);
+	}
+
+	bool IsDirty() const { return DirtyMin != CleanMarker(); }
+
+	// Bring the table up to date with source, which must have the dimensions the table was initialized with.
+	void Update(const FLabyrinthBitPlane& source)
+	{
+		if (!IsDirty())
+		{
+			return;
+		}
+
+		int32 firstX{ FMath::Max(DirtyMin.X, 0) };
+		int32 firstY{ FMath::Max(DirtyMin.Y, 0) };
+
+		// Sums(x + 1, y + 1) counts the set cells in [0, x] x [0, y].
+		for (int32 y = firstY; y < Dimensions.Y; y++)
+		{
+			TConstArrayView<int32> above{ Sums.GetRow(y) };
+			TArrayView<int32> row{ Sums.GetRow(y + 1) };
+
+			for (int32 x = firstX; x < Dimensions.X; x++)
+			{
+				int32 cell{ source.Get(FIntVector2{ x, y }) ? 1 : 0 };
+				row[x + 1] = cell + row[x] + above[x + 1] - above[x];
+			}
+		}
+
+		DirtyMin = CleanMarker();
+	}
+
+	// Set cells in the rectangle starting at min. The rectangle must be inside the table and the table up to date.
+	int32 CountInRect(FIntVector2 min, FIntVector2 size) const
+	{
+		checkSlow(!IsDirty());
+		checkSlow(min.X >= 0 && min.Y >= 0 && min.X + size.X <= Dimensions.X && min.Y + size.Y <= Dimensions.Y);
+
+		FIntVector2 max{ min + size };
+		return Sums[max] - Sums[FIntVector2{ min.X, max.Y }] - Sums[FIntVector2{ max.X, min.Y }] + Sums[min];
+	}
+
+	SIZE_T GetAllocatedSize() const { return Sums.GetAllocatedSize(); }
+
+private:
+	static FIntVector2 CleanMarker() { return FIntVector2{ MAX_int32, MAX_int32 }; }
+
+	TLabyrinthGrid<int32> Sums;
+	FIntVector2 Dimensions{ 0, 0 };
+
+	// Lowest x and y of any cell changed since the last Update
+	FIntVector2 DirtyMin = CleanMarker();
+};
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LabyrinthWavefront.h"
+
+void FLabyrinthWavefront::Prepare(const FLabyrinthBitPlane& impassable)
+{
+    WordsPerRow = impassable.GetWordsPerRow();
+    Height = impassable.GetHeight();
+
+    const int32 bitsInLastWord{ impassable.GetWidth() % FLabyrinthBitPlane::BitsPerWord };
+    LastWordMask = bitsInLastWord == 0 ? ~uint64(0) : (uint64(1) << bitsInLastWord) - 1;
+
+    const int32 numWords{ WordsPerRow * Height };
+    if (Visited.Num() != numWords)
+    {
+        // Both stay all zero between floods, so they only need clearing when resized.
+        Allocations.Init(Visited, uint64(0), numWords);
+        Allocations.Init(Reached, uint64(0), numWords);
+    }
+}
+
+template<typename DistanceType>
+int32 FLabyrinthWavefront::Flood(TLabyrinthGrid<DistanceType>& distances, const FLabyrinthBitPlane& impassable, TConstArrayView<FIntVector2> seeds, bool& bOutSaturated)
+{
+    Prepare(impassable);
+
+    const int32 width{ distances.GetWidth() };
+
+    FrontierWords.Reset();
+    FrontierBits.Reset();
+
+    // Level zero is the seeds themselves, whatever their neighbours hold.
+    for (FIntVector2 seed : seeds)
+    {
+        Reach((seed.Y * WordsPerRow) + (seed.X / FLabyrinthBitPlane::BitsPerWord), uint64(1) << (seed.X % FLabyrinthBitPlane::BitsPerWord));
+    }
+
+    for (int32 wordIndex : ReachedWords)
+    {
+        uint64 bits{ Reached[wordIndex] };
+        Reached[wordIndex] = 0;
+
+        MarkVisited(wordIndex, bits);
+        Allocations.Add(FrontierWords, wordIndex);
+        Allocations.Add(FrontierBits, bits);
+    }
+    ReachedWords.Reset();
+
+    int32 numVisited{ 0 };
+    DistanceType nextDistance{ static_cast<DistanceType>(seeds.IsEmpty() ? 1 : distances[seeds[0]] + 1) };
+    bOutSaturated = false;
+
+    while (FrontierWords.Num() > 0)
+    {
+        if (nextDistance == TNumericLimits<DistanceType>::Max())
+        {
+            bOutSaturated = true;
+            break;
+        }
+
+        // Spread every frontier word into itself and its four neighbouring words.
+        for (int32 frontierIndex = 0; frontierIndex < FrontierWords.Num(); frontierIndex++)
+        {
+            const int32 wordIndex{ FrontierWords[frontierIndex] };
+            const uint64 bits{ FrontierBits[frontierIndex] };
+            const int32 y{ wordIndex / WordsPerRow };
+            const int32 word{ wordIndex % WordsPerRow };
+
+            numVisited += FMath::CountBits(bits);
+
+            // Bit x + 1 from bit x, and bit x - 1 from bit x
+            Reach(wordIndex, (bits << 1) | (bits >> 1));
+
+            // The first cell's left neighbour is the last cell of the previous word, and the reverse on the right.
+            if (word > 0) { Reach(wordIndex - 1, bits << 63); }
+            if (word + 1 < WordsPerRow) { Reach(wordIndex + 1, bits >> 63); }
+
+            if (y > 0) { Reach(wordIndex - WordsPerRow, bits); }
+            if (y + 1 < Height) { Reach(wordIndex + WordsPerRow, bits); }
+        }
+
+        NextFrontierWords.Reset();
+        NextFrontierBits.Reset();
+
+        // Keep the reached cells that are new and passable, and lower the ones this level improves on.
+        for (int32 wordIndex : ReachedWords)
+        {
+            const int32 y{ wordIndex / WordsPerRow };
+            const int32 word{ wordIndex % WordsPerRow };
+
+            uint64 candidates{ Reached[wordIndex] & ~Visited[wordIndex] & ~impassable.GetRowWords(y)[word] };
+            Reached[wordIndex] = 0;
+
+            if (word + 1 == WordsPerRow)
+            {
+                candidates &= LastWordMask;
+            }
+
+            if (candidates == 0)
+            {
+                continue;
+            }
+
+            // A cell already at this distance or closer never improves at a later level, so it is done either way.
+            MarkVisited(wordIndex, candidates);
+
+            uint64 improved{ 0 };
+            const int32 rowStart{ (y * width) + (word * FLabyrinthBitPlane::BitsPerWord) };
+
+            while (candidates != 0)
+            {
+                const int32 bit{ static_cast<int32>(FMath::CountTrailingZeros64(candidates)) };
+                candidates &= candidates - 1;
+
+                DistanceType& distance = distances[rowStart + bit];
+                if (distance > nextDistance)
+                {
+                    distance = nextDistance;
+                    improved |= uint64(1) << bit;
+                }
+            }
+
+            if (improved != 0)
+            {
+                Allocations.Add(NextFrontierWords, wordIndex);
+                Allocations.Add(NextFrontierBits, improved);
+            }
+        }
+        ReachedWords.Reset();
+
+        Swap(FrontierWords, NextFrontierWords);
+        Swap(FrontierBits, NextFrontierBits);
+        nextDistance++;
+    }
+
+    for (int32 wordIndex : VisitedWords)
+    {
+        Visited[wordIndex] = 0;
+    }
+    VisitedWords.Reset();
+
+    return numVisited;
+}
+
+template int32 FLabyrinthWavefront::Flood<uint16>(TLabyrinthGrid<uint16>&, const FLabyrinthBitPlane&, TConstArrayView<FIntVector2>, bool&);
+template int32 FLabyrinthWavefront::Flood<uint32>(TLabyrinthGrid<uint32>&, const FLabyrinthBitPlane&, TConstArrayView<FIntVector2>, bool&);
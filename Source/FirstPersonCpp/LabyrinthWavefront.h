@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "LabyrinthAllocationCounter.h"
+#include "LabyrinthBitPlane.h"
+#include "LabyrinthGrid.h"
+
+/**
+ * Bit-parallel breadth first flood. The frontier is kept as 64 cell words and grown a whole word at a time with shifts
+ * and ORs, then each newly reached cell is given the wavefront index as its distance.
+ * Expands level by level exactly like the queue flood, so the distances it leaves are identical.
+ *
+ * Only words the frontier touches are visited, so a level costs in proportion to the words the frontier occupies
+ * rather than the size of the grid, and nothing is cleared across the whole grid between floods.
+ */
+class FLabyrinthWavefront
+{
+public:
+	// Flood distances outwards from the given seeds, which must all hold the same distance, never entering cells set in impassable.
+	// Only lowers distances. Returns the number of cells expanded, the same count the queue flood returns.
+	// Stops with bOutSaturated set instead of writing the largest value DistanceType holds, which means unreached.
+	template<typename DistanceType>
+	int32 Flood(TLabyrinthGrid<DistanceType>& distances, const FLabyrinthBitPlane& impassable, TConstArrayView<FIntVector2> seeds, bool& bOutSaturated);
+
+	// Times the buffers had to grow
+	int32 GetNumAllocations() const { return Allocations.Num(); }
+	void ResetAllocationCount() { Allocations.Reset(); }
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return
+			Visited.GetAllocatedSize() +
+			Reached.GetAllocatedSize() +
+			VisitedWords.GetAllocatedSize() +
+			ReachedWords.GetAllocatedSize() +
+			FrontierWords.GetAllocatedSize() +
+			FrontierBits.GetAllocatedSize() +
+			NextFrontierWords.GetAllocatedSize() +
+			NextFrontierBits.GetAllocatedSize();
+	}
+
+private:
+	void Prepare(const FLabyrinthBitPlane& impassable);
+
+	// OR bits into the reached word, remembering the word the first time it becomes non zero.
+	void Reach(int32 wordIndex, uint64 bits)
+	{
+		if (bits == 0)
+		{
+			return;
+		}
+
+		if (Reached[wordIndex] == 0)
+		{
+			Allocations.Add(ReachedWords, wordIndex);
+		}
+
+		Reached[wordIndex] |= bits;
+	}
+
+	void MarkVisited(int32 wordIndex, uint64 bits)
+	{
+		if (Visited[wordIndex] == 0)
+		{
+			Allocations.Add(VisitedWords, wordIndex);
+		}
+
+		Visited[wordIndex] |= bits;
+	}
+
+	// Cells already expanded or checked this flood, laid out like the impassable plane. Cleared word by word afterwards.
+	TArray<uint64> Visited;
+	TArray<int32> VisitedWords;
+
+	// Neighbours of the frontier, gathered before they are checked
+	TArray<uint64> Reached;
+	TArray<int32> ReachedWords;
+
+	// Non zero frontier words and their bits for the current and next level
+	TArray<int32> FrontierWords;
+	TArray<uint64> FrontierBits;
+	TArray<int32> NextFrontierWords;
+	TArray<uint64> NextFrontierBits;
+
+	int32 WordsPerRow = 0;
+	int32 Height = 0;
+
+	// Cells of the last word in a row that are inside the grid
+	uint64 LastWordMask = ~uint64(0);
+
+	FLabyrinthAllocationCounter Allocations;
+};
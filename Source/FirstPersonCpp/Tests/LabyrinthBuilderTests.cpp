@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+#include "LabyrinthBuilder.h"
+#include "Room.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    ALabyrinthBuilder* SpawnTestBuilder(UWorld* world, TSubclassOf<ARoom> room, bool bTimeSliced)
+    {
+        ALabyrinthBuilder* builder = world->SpawnActorDeferred<ALabyrinthBuilder>(ALabyrinthBuilder::StaticClass(), FTransform::Identity);
+
+        ULabyrinthBuilderComponent* component = builder->LabyrinthBuilderComponent;
+        component->BuildOnBeginPlay = false;
+        component->Room = room;
+        component->LabyrinthDimensions = FIntVector2{ 40, 40 };
+        component->NumberOfRoomsToSpawn = 6;
+        component->UseExplicitRandomSeed = true;
+
+        // A tiny budget keeps the build in progress over several ticks.
+        component->TimeSliceMaterialization = bTimeSliced;
+        component->MaterializationBudgetMs = 0.1f;
+
+        builder->FinishSpawning(FTransform::Identity);
+        return builder;
+    }
+}
+
+// The server's replicated settings are handed to a second builder the way OnRep_ReplicatedBuildSettings does on a client.
+// Both builders live in one world, so this checks the client side handling but not the replication itself.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLabyrinthBuilderReplicatedSettingsTest, "FirstPersonCpp.Labyrinth.Builder.ReplicatedSettings",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLabyrinthBuilderReplicatedSettingsTest::RunTest(const FString& Parameters)
+{
+    TSubclassOf<ARoom> room{ LoadClass<ARoom>(nullptr, TEXT("/Game/Labyrinth/Blueprints/Room.Room_C")) };
+    if (!TestNotNull(TEXT("Loads the room class"), room.Get()))
+    {
+        return false;
+    }
+
+    UWorld* world = UWorld::CreateWorld(EWorldType::Game, false);
+    FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    worldContext.SetCurrentWorld(world);
+    world->InitializeActorsForPlay(FURL());
+    world->BeginPlay();
+
+    ALabyrinthBuilder* server = SpawnTestBuilder(world, room, false);
+    ALabyrinthBuilder* client = SpawnTestBuilder(world, room, true);
+
+    // Two server builds in a row, as when the server rebuilds before a client has finished the first one.
+    server->LabyrinthBuilderComponent->ExplicitRandomSeed = 42;
+    server->LabyrinthBuilderComponent->BuildLabyrinth();
+    const FLabyrinthBuildSettings firstSettings{ server->ReplicatedBuildSettings };
+
+    server->LabyrinthBuilderComponent->ExplicitRandomSeed = 43;
+    server->LabyrinthBuilderComponent->BuildLabyrinth();
+    const FLabyrinthBuildSettings secondSettings{ server->ReplicatedBuildSettings };
+    const int32 serverHash{ server->LabyrinthBuilderComponent->GetLayoutHash() };
+
+    TestNotEqual(TEXT("Each server build publishes new settings"), secondSettings.BuildId, firstSettings.BuildId);
+
+    ULabyrinthBuilderComponent* clientComponent = client->LabyrinthBuilderComponent;
+    clientComponent->BuildFromSettings(firstSettings);
+    TestTrue(TEXT("The client is still spawning the first build"), clientComponent->IsBuildInProgress());
+
+    clientComponent->BuildFromSettings(secondSettings);
+    TestTrue(TEXT("Settings received mid build are kept"), clientComponent->HasPendingBuildSettings());
+
+    for (int32 frame = 0; frame < 10000 && (clientComponent->IsBuildInProgress() || clientComponent->HasPendingBuildSettings()); frame++)
+    {
+        world->Tick(LEVELTICK_All, 1.0f / 60.0f);
+    }
+
+    TestFalse(TEXT("The client finishes building"), clientComponent->IsBuildInProgress());
+    TestFalse(TEXT("No settings are left pending"), clientComponent->HasPendingBuildSettings());
+    TestEqual(TEXT("The client built the latest seed"), clientComponent->GetLastBuildStats().Seed, secondSettings.Seed);
+    TestEqual(TEXT("Client layout hash"), clientComponent->GetLayoutHash(), serverHash);
+
+    GEngine->DestroyWorldContext(world);
+    world->DestroyWorld(false);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#include "LabyrinthDistanceField.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // Plain breadth first search from the hall cells, as the expected result for a field flooded from scratch.
+    TArray<uint32> ReferenceDistances(const FLabyrinthDistanceField& field)
+    {
+        const FIntVector2 dimensions{ field.GetDimensions() };
+        TArray<uint32> distances;
+        distances.Init(FLabyrinthDistanceField::Unreached, field.Num());
+
+        TArray<FIntVector2> queue;
+        for (int32 y = 0; y < dimensions.Y; y++)
+        {
+            for (int32 x = 0; x < dimensions.X; x++)
+            {
+                if (field.IsHall(FIntVector2{ x, y }))
+                {
+                    distances[(y * dimensions.X) + x] = 0;
+                    queue.Add(FIntVector2{ x, y });
+                }
+            }
+        }
+
+        const FIntVector2 directions[]{ {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+        for (int32 queueIndex = 0; queueIndex < queue.Num(); queueIndex++)
+        {
+            const FIntVector2 cell{ queue[queueIndex] };
+            const uint32 nextDistance{ distances[(cell.Y * dimensions.X) + cell.X] + 1 };
+
+            for (FIntVector2 direction : directions)
+            {
+                const FIntVector2 neighbor{ cell + direction };
+                if (!field.IsInBounds(neighbor) || field.IsRoom(neighbor) || distances[(neighbor.Y * dimensions.X) + neighbor.X] <= nextDistance)
+                {
+                    continue;
+                }
+
+                distances[(neighbor.Y * dimensions.X) + neighbor.X] = nextDistance;
+                queue.Add(neighbor);
+            }
+        }
+
+        return distances;
+    }
+
+    bool MatchesReference(FAutomationTestBase& test, const TCHAR* kernelName, const FLabyrinthDistanceField& field, const TArray<uint32>& expected)
+    {
+        const FIntVector2 dimensions{ field.GetDimensions() };
+        for (int32 y = 0; y < dimensions.Y; y++)
+        {
+            for (int32 x = 0; x < dimensions.X; x++)
+            {
+                if (field.GetDistance(FIntVector2{ x, y }) != expected[(y * dimensions.X) + x])
+                {
+                    test.AddError(FString::Printf(TEXT("%s: cell %i, %i has distance %u, expected %u"),
+                        kernelName, x, y, field.GetDistance(FIntVector2{ x, y }), expected[(y * dimensions.X) + x]));
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool DistancesMatch(FAutomationTestBase& test, const TCHAR* kernelName, const FLabyrinthDistanceField& field, const FLabyrinthDistanceField& expected)
+    {
+        const FIntVector2 dimensions{ field.GetDimensions() };
+        for (int32 y = 0; y < dimensions.Y; y++)
+        {
+            for (int32 x = 0; x < dimensions.X; x++)
+            {
+                const FIntVector2 cell{ x, y };
+                if (field.GetDistance(cell) != expected.GetDistance(cell))
+                {
+                    test.AddError(FString::Printf(TEXT("%s: cell %i, %i has distance %u, the queue flood left %u"),
+                        kernelName, x, y, field.GetDistance(cell), expected.GetDistance(cell)));
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Scatter rooms and hall cells over the free cells of the field. Returns the new hall cells.
+    TArray<FIntVector2> ScatterCells(FLabyrinthDistanceField& field, FRandomStream& random, float roomChance, float hallChance)
+    {
+        TArray<FIntVector2> newHalls;
+        const FIntVector2 dimensions{ field.GetDimensions() };
+
+        for (int32 y = 0; y < dimensions.Y; y++)
+        {
+            for (int32 x = 0; x < dimensions.X; x++)
+            {
+                const FIntVector2 cell{ x, y };
+                if (field.IsBlocked(cell))
+                {
+                    continue;
+                }
+
+                const float roll{ random.GetFraction() };
+                if (roll < roomChance)
+                {
+                    field.SetRoom(cell);
+                }
+                else if (roll < roomChance + hallChance)
+                {
+                    field.SetHall(cell);
+                    newHalls.Add(cell);
+                }
+            }
+        }
+
+        return newHalls;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLabyrinthDistanceFieldSaturationTest, "FirstPersonCpp.Labyrinth.DistanceField.Saturation",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLabyrinthDistanceFieldSaturationTest::RunTest(const FString& Parameters)
+{
+    // A serpentine corridor 400 cells wide and 200 rows long, so distances run past what uint16 holds.
+    constexpr int32 Size{ 400 };
+
+    FLabyrinthDistanceField field;
+    field.Init(FIntVector2{ Size, Size });
+
+    for (int32 y = 1; y < Size; y += 2)
+    {
+        const int32 gapX{ (y / 2) % 2 == 0 ? Size - 1 : 0 };
+        for (int32 x = 0; x < Size; x++)
+        {
+            if (x != gapX)
+            {
+                field.SetRoom(FIntVector2{ x, y });
+            }
+        }
+    }
+
+    const FIntVector2 seeds[]{ { 0, 0 } };
+    field.SetHall(seeds[0]);
+
+    const TArray<uint32> expected{ ReferenceDistances(field) };
+    TestTrue(TEXT("The corridor is longer than uint16 distances"), expected[(Size - 1) * Size] > MAX_uint16);
+
+    FLabyrinthDistanceField queueField{ field };
+    TLabyrinthRingBuffer<int32> frontier;
+    int32 queueVisited{ queueField.Flood(seeds, frontier) };
+
+    FLabyrinthDistanceField wavefrontField{ field };
+    FLabyrinthWavefront wavefront;
+    int32 wavefrontVisited{ wavefrontField.Flood(seeds, wavefront) };
+
+    FLabyrinthDistanceField parallelField{ field };
+    FLabyrinthParallelFlood parallelFlood;
+    int32 parallelVisited{ parallelField.Flood(seeds, parallelFlood) };
+
+    TestFalse(TEXT("Queue flood widened the distances"), queueField.UsesCompactDistances());
+    TestFalse(TEXT("Wavefront flood widened the distances"), wavefrontField.UsesCompactDistances());
+    TestFalse(TEXT("Parallel flood widened the distances"), parallelField.UsesCompactDistances());
+
+    MatchesReference(*this, TEXT("Queue flood"), queueField, expected);
+    MatchesReference(*this, TEXT("Wavefront flood"), wavefrontField, expected);
+    MatchesReference(*this, TEXT("Parallel flood"), parallelField, expected);
+
+    TestEqual(TEXT("Wavefront visited count"), wavefrontVisited, queueVisited);
+    TestEqual(TEXT("Parallel visited count"), parallelVisited, queueVisited);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLabyrinthDistanceFieldKernelTest, "FirstPersonCpp.Labyrinth.DistanceField.Kernels",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLabyrinthDistanceFieldKernelTest::RunTest(const FString& Parameters)
+{
+    // Not a multiple of 64 wide, so the last word of each row is partly outside the grid.
+    const FIntVector2 dimensions{ 500, 300 };
+
+    TLabyrinthRingBuffer<int32> frontier;
+    FLabyrinthWavefront wavefront;
+    FLabyrinthParallelFlood parallelFlood;
+
+    for (int32 seed : { 1, 2, 3 })
+    {
+        FRandomStream random{ seed };
+
+        // Flood once so the kernels below start from distances that are already there, as incremental updates do.
+        FLabyrinthDistanceField field;
+        field.Init(dimensions);
+        TArray<FIntVector2> firstHalls{ ScatterCells(field, random, 0.25f, 0.01f) };
+        field.Flood(firstHalls, frontier);
+
+        // New rooms cut through the flooded distances, and new halls seed the next flood.
+        TArray<FIntVector2> newHalls{ ScatterCells(field, random, 0.05f, 0.05f) };
+
+        FLabyrinthDistanceField queueField{ field };
+        int32 queueVisited{ queueField.Flood(newHalls, frontier) };
+
+        FLabyrinthDistanceField wavefrontField{ field };
+        int32 wavefrontVisited{ wavefrontField.Flood(newHalls, wavefront) };
+
+        // Thousands of new halls, so the first levels are split across several parallel chunks.
+        FLabyrinthDistanceField parallelField{ field };
+        int32 parallelVisited{ parallelField.Flood(newHalls, parallelFlood) };
+
+        DistancesMatch(*this, *FString::Printf(TEXT("Wavefront flood, seed %i"), seed), wavefrontField, queueField);
+        TestEqual(FString::Printf(TEXT("Wavefront visited count, seed %i"), seed), wavefrontVisited, queueVisited);
+
+        DistancesMatch(*this, *FString::Printf(TEXT("Parallel flood, seed %i"), seed), parallelField, queueField);
+        TestEqual(FString::Printf(TEXT("Parallel visited count, seed %i"), seed), parallelVisited, queueVisited);
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
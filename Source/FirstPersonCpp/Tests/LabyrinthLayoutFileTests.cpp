@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "LabyrinthLayoutFile.h"
+#include "LabyrinthLayoutGenerator.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLabyrinthLayoutFileRoundTripTest, "FirstPersonCpp.Labyrinth.LayoutFile.RoundTrip",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLabyrinthLayoutFileRoundTripTest::RunTest(const FString& Parameters)
+{
+    FLabyrinthLayoutParams params{};
+    params.Seed = 42;
+    params.Dimensions = FIntVector2{ 64, 64 };
+    params.NumberOfRooms = 12;
+    params.RoomCellSize = FIntVector2{ 3, 3 };
+    params.RoomDoors.Add(FTransform{ FRotator{ 0.0, 0.0, 0.0 }, FVector{ 6.0, 3.0, 0.0 } });
+    params.RoomDoors.Add(FTransform{ FRotator{ 0.0, 180.0, 0.0 }, FVector{ 0.0, 3.0, 0.0 } });
+
+    FLabyrinthLayoutGenerator generator;
+    FLabyrinthLayout layout;
+    if (!TestTrue(TEXT("Generates"), generator.Generate(params, layout)))
+    {
+        return false;
+    }
+
+    const FString path{ FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("LabyrinthLayoutFileRoundTrip.labyrinth")) };
+    TestTrue(TEXT("Saves"), FLabyrinthLayoutFile::Save(layout, path));
+
+    {
+        FLabyrinthLayoutFile layoutFile;
+        if (TestTrue(TEXT("Opens"), layoutFile.Open(path)))
+        {
+            FLabyrinthLayout loadedLayout;
+            layoutFile.CopyToLayout(loadedLayout, params.RoomDoors);
+
+            TestEqual(TEXT("Loaded hall cells"), loadedLayout.HallCells, layout.HallCells);
+            TestEqual(TEXT("Loaded layout hash"), loadedLayout.ComputeHash(), layout.ComputeHash());
+        }
+    }
+
+    // Flip one bit of the first hall cell. The header still describes a valid file, only the hash can catch it.
+    TArray64<uint8> bytes;
+    FLabyrinthLayoutFile::Write(layout, bytes);
+
+    const FLabyrinthLayoutFileHeader& header = *reinterpret_cast<const FLabyrinthLayoutFileHeader*>(bytes.GetData());
+    if (TestTrue(TEXT("Has hall cells"), header.NumHallCells > 0))
+    {
+        bytes[header.HallCellsOffset] ^= 1;
+        FFileHelper::SaveArrayToFile(bytes, *path);
+
+        FLabyrinthLayoutFile layoutFile;
+        AddExpectedMessage(TEXT("has hash"), ELogVerbosity::Warning, EAutomationExpectedMessageFlags::Contains, 2);
+        TestFalse(TEXT("Opens with a corrupt hall cell"), layoutFile.Open(path));
+
+        // The hall cell is still inside the labyrinth, so only the skipped checksums would have caught it.
+        if (TestTrue(TEXT("Opens with a corrupt hall cell without checksums"), layoutFile.Open(path, false)))
+        {
+            TestFalse(TEXT("Checksums of a corrupt hall cell"), layoutFile.VerifyChecksums());
+        }
+    }
+
+    IFileManager::Get().Delete(*path);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,299 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+
+#include "LabyrinthLayoutGenerator.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    const int32 TestSeeds[]{ 1, 7, 42, 1234, 99991 };
+
+    // 3 x 3 cell rooms with a door in the middle of each side, so every room has hallways to lay.
+    FLabyrinthLayoutParams MakeTestParams(int32 seed)
+    {
+        FLabyrinthLayoutParams params{};
+        params.Seed = seed;
+        params.Dimensions = FIntVector2{ 64, 64 };
+        params.NumberOfRooms = 12;
+        params.CellUnit = 2.0;
+        params.RoomCellSize = FIntVector2{ 3, 3 };
+
+        params.RoomDoors.Add(FTransform{ FRotator{ 0.0, 0.0, 0.0 }, FVector{ 6.0, 3.0, 0.0 } });
+        params.RoomDoors.Add(FTransform{ FRotator{ 0.0, 180.0, 0.0 }, FVector{ 0.0, 3.0, 0.0 } });
+        params.RoomDoors.Add(FTransform{ FRotator{ 0.0, 90.0, 0.0 }, FVector{ 3.0, 6.0, 0.0 } });
+        params.RoomDoors.Add(FTransform{ FRotator{ 0.0, -90.0, 0.0 }, FVector{ 3.0, 0.0, 0.0 } });
+
+        return params;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLabyrinthIncrementalDistanceFieldTest, "FirstPersonCpp.Labyrinth.Generator.IncrementalDistanceField",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLabyrinthIncrementalDistanceFieldTest::RunTest(const FString& Parameters)
+{
+    FLabyrinthLayoutGenerator generator;
+    FLabyrinthLayout incrementalLayout;
+    FLabyrinthLayout fullLayout;
+
+    for (int32 seed : TestSeeds)
+    {
+        FLabyrinthLayoutParams params{ MakeTestParams(seed) };
+
+        params.bIncrementalDistanceField = true;
+        if (!TestTrue(FString::Printf(TEXT("Seed %i generates incrementally"), seed), generator.Generate(params, incrementalLayout)))
+        {
+            continue;
+        }
+
+        params.bIncrementalDistanceField = false;
+        if (!TestTrue(FString::Printf(TEXT("Seed %i generates with full floods"), seed), generator.Generate(params, fullLayout)))
+        {
+            continue;
+        }
+
+        TestTrue(FString::Printf(TEXT("Seed %i lays hallways"), seed), incrementalLayout.HallCells.Num() > 0);
+        TestEqual(FString::Printf(TEXT("Seed %i layout hash"), seed), incrementalLayout.ComputeHash(), fullLayout.ComputeHash());
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLabyrinthDistanceFieldKernelLayoutTest, "FirstPersonCpp.Labyrinth.Generator.DistanceFieldKernels",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLabyrinthDistanceFieldKernelLayoutTest::RunTest(const FString& Parameters)
+{
+    FLabyrinthLayoutGenerator generator;
+    FLabyrinthLayout queueLayout;
+    FLabyrinthLayout wavefrontLayout;
+    FLabyrinthLayout parallelLayout;
+
+    for (int32 seed : TestSeeds)
+    {
+        FLabyrinthLayoutParams params{ MakeTestParams(seed) };
+        params.ParallelDistanceFieldMinCells = 0;
+
+        params.bWavefrontDistanceField = false;
+        if (!TestTrue(FString::Printf(TEXT("Seed %i generates with the queue flood"), seed), generator.Generate(params, queueLayout)))
+        {
+            continue;
+        }
+
+        params.bWavefrontDistanceField = true;
+        if (!TestTrue(FString::Printf(TEXT("Seed %i generates with the wavefront flood"), seed), generator.Generate(params, wavefrontLayout)))
+        {
+            continue;
+        }
+
+        TestEqual(FString::Printf(TEXT("Seed %i wavefront layout hash"), seed), wavefrontLayout.ComputeHash(), queueLayout.ComputeHash());
+
+        // Lowered so this small labyrinth floods in parallel too.
+        params.bWavefrontDistanceField = false;
+        params.ParallelDistanceFieldMinCells = 1;
+        if (!TestTrue(FString::Printf(TEXT("Seed %i generates with the parallel flood"), seed), generator.Generate(params, parallelLayout)))
+        {
+            continue;
+        }
+
+        TestEqual(FString::Printf(TEXT("Seed %i parallel layout hash"), seed), parallelLayout.ComputeHash(), queueLayout.ComputeHash());
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLabyrinthNoValidDoorTest, "FirstPersonCpp.Labyrinth.Generator.NoValidDoor",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLabyrinthNoValidDoorTest::RunTest(const FString& Parameters)
+{
+    // Four cells wide, so the first room sits at x = 1 with its one door in column 0, and a room at x = 0 has its door
+    // off the grid. Column 0 is flooded from the first room's door, so a walk started from (0, 0) would find a way.
+    FLabyrinthLayoutParams params{};
+    params.Dimensions = FIntVector2{ 4, 12 };
+    params.NumberOfRooms = 2;
+    params.CellUnit = 2.0;
+    params.RoomCellSize = FIntVector2{ 3, 3 };
+    params.PlacementStrategy = ELabyrinthPlacementStrategy::EmptySquares;
+    params.RoomDoors.Add(FTransform{ FRotator{ 0.0, 180.0, 0.0 }, FVector{ 0.0, 3.0, 0.0 } });
+
+    FLabyrinthLayoutGenerator generator;
+    FLabyrinthLayout layout;
+    int32 numUnconnectedRooms{ 0 };
+    int32 numRoomsAboveFirst{ 0 };
+
+    for (int32 seed = 1; seed <= 32; seed++)
+    {
+        params.Seed = seed;
+        if (!TestTrue(FString::Printf(TEXT("Seed %i generates"), seed), generator.Generate(params, layout)) ||
+            !TestEqual(FString::Printf(TEXT("Seed %i rooms"), seed), layout.Rooms.Num(), 2))
+        {
+            continue;
+        }
+
+        // Legitimate hallways start at a door in column 0 at least one row up, so none of them covers the corner.
+        TestFalse(FString::Printf(TEXT("Seed %i lays a hall cell at 0, 0"), seed), layout.HallCells.Contains(FIntVector2{ 0, 0 }));
+
+        if (layout.Rooms[1].X == 0)
+        {
+            numUnconnectedRooms++;
+            numRoomsAboveFirst += layout.Rooms[1].Y > layout.Rooms[0].Y ? 1 : 0;
+        }
+    }
+
+    // Below the first room the stale walk from the corner runs into the new room, so only rooms above show the problem.
+    TestTrue(TEXT("Some seed places a room without a valid door above the first room"), numRoomsAboveFirst > 0);
+
+    if (numUnconnectedRooms > 0)
+    {
+        AddExpectedMessage(TEXT("left unconnected"), ELogVerbosity::Warning, EAutomationExpectedMessageFlags::Contains, numUnconnectedRooms);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLabyrinthBatchedConnectionTest, "FirstPersonCpp.Labyrinth.Generator.BatchedConnections",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLabyrinthBatchedConnectionTest::RunTest(const FString& Parameters)
+{
+    // A batch stamps all its rooms before connecting any, so the field the later rooms walk on is the most out of date.
+    for (int32 batchSize : { 4, 8 })
+    {
+        FLabyrinthLayoutGenerator generator;
+        FLabyrinthLayout layout;
+
+        for (int32 seed : TestSeeds)
+        {
+            FLabyrinthLayoutParams params{ MakeTestParams(seed) };
+            params.NumCandidateRays = 4;
+            params.RoomBatchSize = batchSize;
+
+            const FString context{ FString::Printf(TEXT("Batches of %i, seed %i"), batchSize, seed) };
+            if (!TestTrue(context + TEXT(" generates"), generator.Generate(params, layout)))
+            {
+                continue;
+            }
+
+            TestEqual(context + TEXT(" unconnected rooms"), generator.GetStats().NumUnconnectedRooms, 0);
+
+            // The walk from the chosen door turns that door's cell into a hall, which is what opens the door.
+            // The first room has nothing to connect to when it is placed, so it is left out.
+            for (int32 roomIndex = 1; roomIndex < layout.Rooms.Num(); roomIndex++)
+            {
+                bool bHasOpenDoor{ false };
+                for (int32 doorIndex = 0; doorIndex < layout.GetDoorsPerRoom(); doorIndex++)
+                {
+                    bHasOpenDoor |= layout.IsDoorOpen(roomIndex, doorIndex);
+                }
+
+                if (!bHasOpenDoor)
+                {
+                    AddError(FString::Printf(TEXT("%s leaves the room at %i, %i without a door onto a hall"),
+                        *context, layout.Rooms[roomIndex].X, layout.Rooms[roomIndex].Y));
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLabyrinthScratchAllocationTest, "FirstPersonCpp.Labyrinth.Generator.ScratchAllocations",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLabyrinthScratchAllocationTest::RunTest(const FString& Parameters)
+{
+    // The parallel flood is left out, as which chunk claims a cell, and so which chunk buffer grows, depends on timing.
+    for (bool bWavefront : { false, true })
+    {
+        FLabyrinthLayoutGenerator generator;
+        FLabyrinthLayout layout;
+
+        FLabyrinthLayoutParams params{ MakeTestParams(TestSeeds[0]) };
+        params.bWavefrontDistanceField = bWavefront;
+
+        const TCHAR* kernelName{ bWavefront ? TEXT("wavefront") : TEXT("queue") };
+        if (!TestTrue(FString::Printf(TEXT("Generates with the %s flood"), kernelName), generator.Generate(params, layout)))
+        {
+            continue;
+        }
+
+        TestTrue(FString::Printf(TEXT("The first build with the %s flood grows its buffers"), kernelName), generator.GetNumScratchAllocations() > 0);
+
+        if (TestTrue(FString::Printf(TEXT("Generates again with the %s flood"), kernelName), generator.Generate(params, layout)))
+        {
+            TestEqual(FString::Printf(TEXT("Scratch allocations rebuilding with the %s flood"), kernelName), generator.GetNumScratchAllocations(), 0);
+        }
+    }
+
+    return true;
+}
+
+// A listen server and its clients each generate from the replicated FLabyrinthBuildSettings, so equal hashes here are
+// what keeps them in sync. Comparing a real server and client needs a networked PIE session and is not covered here.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLabyrinthDeterminismTest, "FirstPersonCpp.Labyrinth.Generator.Determinism",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FLabyrinthDeterminismTest::RunTest(const FString& Parameters)
+{
+    const ELabyrinthPlacementStrategy strategies[]{
+        ELabyrinthPlacementStrategy::SearchRays,
+        ELabyrinthPlacementStrategy::Bitboard,
+        ELabyrinthPlacementStrategy::EmptySquares };
+
+    for (ELabyrinthPlacementStrategy strategy : strategies)
+    {
+        // The reused generator last built another seed, so stale scratch state would show up as a different hash.
+        FLabyrinthLayoutGenerator reusedGenerator;
+        FLabyrinthLayout reusedLayout;
+
+        for (int32 seed : TestSeeds)
+        {
+            FLabyrinthLayoutParams params{ MakeTestParams(seed) };
+            params.PlacementStrategy = strategy;
+
+            // Several rays and batched rooms run on worker threads, which must not change the result either.
+            if (strategy == ELabyrinthPlacementStrategy::SearchRays && seed % 2 == 1)
+            {
+                params.NumCandidateRays = 4;
+                params.RoomBatchSize = 4;
+            }
+
+            FLabyrinthLayoutGenerator firstGenerator;
+            FLabyrinthLayout firstLayout;
+            FLabyrinthLayoutGenerator secondGenerator;
+            FLabyrinthLayout secondLayout;
+
+            const FString context{ FString::Printf(TEXT("%s seed %i"), *StaticEnum<ELabyrinthPlacementStrategy>()->GetNameStringByValue(static_cast<int64>(strategy)), seed) };
+
+            if (!TestTrue(context + TEXT(" generates"), firstGenerator.Generate(params, firstLayout)) ||
+                !TestTrue(context + TEXT(" generates again"), secondGenerator.Generate(params, secondLayout)) ||
+                !TestTrue(context + TEXT(" generates on a reused generator"), reusedGenerator.Generate(params, reusedLayout)))
+            {
+                continue;
+            }
+
+            TestEqual(context + TEXT(" rooms"), secondLayout.Rooms.Num(), firstLayout.Rooms.Num());
+
+            // Every strategy leaves the same margin as the search rays, whose room extents must stay inside the labyrinth.
+            for (FIntVector2 room : firstLayout.Rooms)
+            {
+                if (room.X + params.RoomCellSize.X >= params.Dimensions.X || room.Y + params.RoomCellSize.Y >= params.Dimensions.Y)
+                {
+                    AddError(FString::Printf(TEXT("%s places a room at %i, %i against the far edge"), *context, room.X, room.Y));
+                }
+            }
+
+            TestFalse(context + TEXT(" lays a hall cell at 0, 0"), firstLayout.HallCells.Contains(FIntVector2{ 0, 0 }));
+            TestEqual(context + TEXT(" layout hash"), secondLayout.ComputeHash(), firstLayout.ComputeHash());
+            TestEqual(context + TEXT(" layout hash on a reused generator"), reusedLayout.ComputeHash(), firstLayout.ComputeHash());
+        }
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS